@@ -32,6 +32,20 @@ message(STATUS "found boost at ${Boost_INCLUDE_DIRS}")
 pkg_check_modules(libelf REQUIRED libelf)
 message(STATUS "found libelf at ${libelf_INCLUDE_DIRS}")
 
+# liburing
+if(HERMES_ENABLE_IO_URING)
+  pkg_check_modules(liburing REQUIRED liburing)
+  message(STATUS "found liburing at ${liburing_INCLUDE_DIRS}")
+endif()
+
+# LZ4 and Zstd
+if(HERMES_ENABLE_COMPRESSION)
+  pkg_check_modules(liblz4 REQUIRED liblz4)
+  message(STATUS "found liblz4 at ${liblz4_INCLUDE_DIRS}")
+  pkg_check_modules(libzstd REQUIRED libzstd)
+  message(STATUS "found libzstd at ${libzstd_INCLUDE_DIRS}")
+endif()
+
 # LIBAIO
 # find_library(LIBAIO_LIBRARY NAMES aio)
 # if(LIBAIO_LIBRARY)
@@ -14,6 +14,8 @@
 #include <mpi.h>
 
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "chimaera/work_orchestrator/affinity.h"
 #include "hermes/bucket.h"
@@ -142,6 +144,130 @@ void PartialPutGetTest(int nprocs, int rank, int repeat, size_t blobs_per_rank,
   PartialGetTest(nprocs, rank, repeat, blobs_per_rank, blob_size, part_size);
 }
 
+/** Run a function in nthreads client threads and wait for them */
+template <typename FUNC> void RunThreads(int nthreads, FUNC &&func) {
+  std::vector<std::thread> threads;
+  threads.reserve(nthreads);
+  for (int tid = 0; tid < nthreads; ++tid) {
+    threads.emplace_back(func, tid);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+/**
+ * Each process PUTs then GETs distinct blobs from 1, 2, 4, ..., max_threads
+ * client threads. The runtime is a separate process, so its worker count
+ * cannot be changed from here: the thread sweep varies how many requests are
+ * in flight at once against a fixed set of workers. Blobs hash to different
+ * lanes, so throughput should grow until the in-flight requests exceed the
+ * workers and then flatten. The knee is the effective worker parallelism.
+ *
+ * To get throughput vs. workers, restart the runtime once per worker count
+ * in the chimaera server config and rerun with max_threads >= that count.
+ * workers is only a label: it tags each result so the runs can be merged.
+ * */
+void ScaleTest(int nprocs, int rank, size_t blobs_per_thread, size_t blob_size,
+               int max_threads, int workers) {
+  for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+    size_t ops = nprocs * nthreads * blobs_per_thread;
+    auto blob_name = [&](int tid, size_t i) {
+      return hshm::Formatter::format("{}.{}.{}.{}", nthreads, rank, tid, i);
+    };
+    // PUT phase
+    MpiTimer put_t(MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    put_t.Resume();
+    RunThreads(nthreads, [&](int tid) {
+      hermes::Context ctx;
+      hermes::Bucket bkt("scale", ctx);
+      hermes::Blob blob(blob_size);
+      for (size_t i = 0; i < blobs_per_thread; ++i) {
+        bkt.Put(blob_name(tid, i), blob, ctx);
+      }
+    });
+    put_t.Pause();
+    GatherTimes(hshm::Formatter::format("ScalePut(workers={},threads={})",
+                                        workers, nthreads),
+                ops * blob_size, put_t);
+    GatherTimes(hshm::Formatter::format("ScalePutOps(workers={},threads={})",
+                                        workers, nthreads),
+                ops, put_t);
+    // GET phase
+    MpiTimer get_t(MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    get_t.Resume();
+    RunThreads(nthreads, [&](int tid) {
+      hermes::Context ctx;
+      hermes::Bucket bkt("scale", ctx);
+      hermes::Blob ret(blob_size);
+      for (size_t i = 0; i < blobs_per_thread; ++i) {
+        bkt.Get(blob_name(tid, i), ret, ctx);
+      }
+    });
+    get_t.Pause();
+    GatherTimes(hshm::Formatter::format("ScaleGet(workers={},threads={})",
+                                        workers, nthreads),
+                ops * blob_size, get_t);
+    GatherTimes(hshm::Formatter::format("ScaleGetOps(workers={},threads={})",
+                                        workers, nthreads),
+                ops, get_t);
+  }
+}
+
+/**
+ * Microbenchmark of locating the buffer of a 4KB partial I/O in a blob made
+ * of 1, 4, 16, ..., max_buffers buffers. Compares a linear scan of
+ * BlobInfo::buffers_ with the prefix-sum binary search (FindBuffer).
+ * Does not contact the runtime.
+ * */
+void BufferLookupTest(int nprocs, int rank, size_t max_buffers,
+                      size_t lookups) {
+  size_t page = KILOBYTES(4);
+  for (size_t nbufs = 1; nbufs <= max_buffers; nbufs *= 4) {
+    hermes::BlobInfo blob_info;
+    for (size_t i = 0; i < nbufs; ++i) {
+      chi::Block block;
+      block.off_ = i * page;
+      block.size_ = page;
+      blob_info.AppendBuffer(hermes::TargetId(), block);
+    }
+    size_t capacity = blob_info.GetBufferCapacity();
+    size_t found = 0;
+    // Linear scan
+    MpiTimer scan_t(MPI_COMM_WORLD);
+    scan_t.Resume();
+    for (size_t i = 0; i < lookups; ++i) {
+      size_t off = (i * 7919 * page) % capacity;
+      size_t cur_off = 0;
+      for (size_t j = 0; j < blob_info.buffers_.size(); ++j) {
+        if (off < cur_off + blob_info.buffers_[j].size_) {
+          found += j;
+          break;
+        }
+        cur_off += blob_info.buffers_[j].size_;
+      }
+    }
+    scan_t.Pause();
+    // Binary search
+    MpiTimer search_t(MPI_COMM_WORLD);
+    search_t.Resume();
+    for (size_t i = 0; i < lookups; ++i) {
+      size_t off = (i * 7919 * page) % capacity;
+      found -= blob_info.FindBuffer(off);
+    }
+    search_t.Pause();
+    if (found != 0) {
+      HELOG(kFatal, "Linear scan and binary search disagree");
+    }
+    GatherTimes(hshm::Formatter::format("BufferScanOps(buffers={})", nbufs),
+                nprocs * lookups, scan_t);
+    GatherTimes(hshm::Formatter::format("BufferSearchOps(buffers={})", nbufs),
+                nprocs * lookups, search_t);
+  }
+}
+
 /** Each process creates a set of buckets */
 void CreateBucketTest(int nprocs, int rank, size_t bkts_per_rank) {
   MpiTimer t(MPI_COMM_WORLD);
@@ -226,6 +352,10 @@ void help() {
   printf(
       "USAGE: ./api_bench pputget [blob_size (K/M/G)] [part_size (K/M/G)] "
       "[blobs_per_rank]\n");
+  printf(
+      "USAGE: ./api_bench scale [blob_size (K/M/G)] [blobs_per_thread] "
+      "[max_threads] [workers]\n");
+  printf("USAGE: ./api_bench buffer_lookup [max_buffers] [lookups]\n");
   printf("USAGE: ./api_bench create_bkt [bkts_per_rank]\n");
   printf("USAGE: ./api_bench get_bkt [bkts_per_rank]\n");
   printf("USAGE: ./api_bench create_blob_1bkt [blobs_per_rank]\n");
@@ -272,6 +402,19 @@ int main(int argc, char **argv) {
       size_t part_size = hshm::ConfigParse::ParseSize(argv[3]);
       size_t blobs_per_rank = atoi(argv[4]);
       PartialPutGetTest(nprocs, rank, 1, blobs_per_rank, blob_size, part_size);
+    } else if (mode == "scale") {
+      REQUIRE_ARGC(6)
+      size_t blob_size = hshm::ConfigParse::ParseSize(argv[2]);
+      size_t blobs_per_thread = atoi(argv[3]);
+      int max_threads = atoi(argv[4]);
+      int workers = atoi(argv[5]);
+      ScaleTest(nprocs, rank, blobs_per_thread, blob_size, max_threads,
+                workers);
+    } else if (mode == "buffer_lookup") {
+      REQUIRE_ARGC(4)
+      size_t max_buffers = atoi(argv[2]);
+      size_t lookups = atoi(argv[3]);
+      BufferLookupTest(nprocs, rank, max_buffers, lookups);
     } else if (mode == "create_bkt") {
       REQUIRE_ARGC(3)
       size_t bkts_per_rank = atoi(argv[2]);
@@ -43,6 +43,7 @@ enum class AdapterMode {
 struct AdapterObjectConfig {
   AdapterMode mode_;
   size_t page_size_;
+  bool direct_io_ = false; /**< Stage to the file with O_DIRECT */
 };
 
 /** Adapter Mode converter */
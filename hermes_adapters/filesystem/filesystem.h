@@ -29,6 +29,7 @@
 #include "filesystem_mdm.h"
 #include "hermes/bucket.h"
 #include "hermes/data_stager/binary_stager.h"
+#include "hermes/data_stager/direct_stager.h"
 #include "hermes/hermes.h"
 #include "hermes_adapters/adapter_types.h"
 #include "hermes_adapters/mapper/mapper_factory.h"
@@ -95,8 +96,13 @@ public:
       // Update page size
       stat.page_size_ = mdm->GetAdapterPageSize(path);
       // Bucket parameters
-      ctx.bkt_params_ =
-          hermes::BinaryFileStager::BuildFileParams(stat.page_size_);
+      if (mdm->IsAdapterDirectIo(path)) {
+        ctx.bkt_params_ =
+            hermes::DirectFileStager::BuildFileParams(stat.page_size_);
+      } else {
+        ctx.bkt_params_ =
+            hermes::BinaryFileStager::BuildFileParams(stat.page_size_);
+      }
       // Get or create the bucket
       if (stat.hflags_.Any(HERMES_FS_TRUNC)) {
         // The file was opened with TRUNCATION
@@ -174,14 +180,16 @@ public:
       mapper->map(off, total_size, stat.page_size_, mapping);
       size_t data_offset = 0;
 
-      // Perform a PartialPut for each page
+      // Put all pages in a single batch, addressing pages by ID
+      Blob data((const char *)ptr, total_size);
+      std::vector<std::string> blob_names;
+      std::vector<BlobBatchEntry> entries;
+      entries.reserve(mapping.size());
       for (const BlobPlacement &p : mapping) {
-        Blob page((const char *)ptr + data_offset, p.blob_size_);
-        std::string blob_name(p.CreateBlobName().str());
-        // bkt.AsyncPartialPut(blob_name, page, p.blob_off_, ctx);
-        bkt.PartialPut(blob_name, page, p.blob_off_, ctx);
+        AddPageEntry(bkt, p, data.shm() + data_offset, blob_names, entries);
         data_offset += p.blob_size_;
       }
+      bkt.ShmBasePutMany<true>(blob_names, entries, ctx);
       if (opts.DoSeek()) {
         stat.st_ptr_ = off + total_size;
       }
@@ -194,6 +202,22 @@ public:
     return total_size;
   }
 
+  /**
+   * Add the batch entry of page \a p. Pages are addressed by ID, or by
+   * name if they lie past the range of page IDs.
+   * */
+  static void AddPageEntry(hapi::Bucket &bkt, const BlobPlacement &p,
+                           const hipc::Pointer &data,
+                           std::vector<std::string> &blob_names,
+                           std::vector<BlobBatchEntry> &entries) {
+    BlobId blob_id = bkt.GetPageId(p.page_);
+    if (blob_id.IsNull()) {
+      blob_names.resize(entries.size());
+      blob_names.emplace_back(p.CreateBlobName().str());
+    }
+    entries.emplace_back(blob_id, p.blob_off_, p.blob_size_, data);
+  }
+
   /** base read function */
   template <bool ASYNC>
   size_t BaseRead(File &f, AdapterStat &stat, void *ptr, size_t off,
@@ -256,25 +280,47 @@ public:
     mapper->map(off, total_size, stat.page_size_, mapping);
     size_t data_offset = 0;
 
-    // Perform a PartialPut for each page
     Context ctx;
     ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
-    for (const BlobPlacement &p : mapping) {
-      Blob page((const char *)ptr + data_offset, p.blob_size_);
-      std::string blob_name(p.CreateBlobName().str());
-      if constexpr (ASYNC) {
+    if constexpr (!ASYNC) {
+      // Get all pages in a single batch, addressing pages by ID
+      Blob data(total_size);
+      std::vector<std::string> blob_names;
+      std::vector<BlobBatchEntry> entries;
+      entries.reserve(mapping.size());
+      for (const BlobPlacement &p : mapping) {
+        AddPageEntry(bkt, p, data.shm() + data_offset, blob_names, entries);
+        data_offset += p.blob_size_;
+      }
+      bkt.ShmBaseGetMany(blob_names, entries, ctx);
+      // Copy out the contiguous prefix that was read
+      data_offset = 0;
+      for (size_t i = 0; i < entries.size(); ++i) {
+        data_offset += entries[i].data_size_;
+        if (entries[i].data_size_ != mapping[i].blob_size_) {
+          break;
+        }
+      }
+      memcpy(ptr, data.data(), data_offset);
+    } else {
+      // Perform an AsyncPartialGet for each page
+      for (const BlobPlacement &p : mapping) {
+        Blob page((const char *)ptr + data_offset, p.blob_size_);
         GetBlobAsyncTask task;
         task.orig_data_ = (char *)ptr + data_offset;
         task.orig_size_ = p.blob_size_;
-        task.task_ = bkt.AsyncPartialGet(blob_name, page, p.blob_off_, ctx);
+        BlobId blob_id = bkt.GetPageId(p.page_);
+        if (blob_id.IsNull()) {
+          task.task_ = bkt.AsyncPartialGet(p.CreateBlobName().str(), page,
+                                           p.blob_off_, ctx);
+        } else {
+          task.task_ = bkt.AsyncPartialGet(blob_id, page, p.blob_off_, ctx);
+        }
         tasks.emplace_back(task);
-      } else {
-        bkt.PartialGet(blob_name, page, p.blob_off_, ctx);
-        memcpy((char *)ptr + data_offset, page.data(), page.size());
-      }
-      data_offset += page.size();
-      if (page.size() != p.blob_size_) {
-        break;
+        data_offset += page.size();
+        if (page.size() != p.blob_size_) {
+          break;
+        }
       }
     }
     if (opts.DoSeek()) {
@@ -420,8 +466,10 @@ public:
 
   /** truncate */
   int Truncate(File &f, AdapterStat &stat, size_t new_size) {
-    // hapi::Bucket &bkt = stat.bkt_id_;
-    // TODO(llogan)
+    if (stat.adapter_mode_ == AdapterMode::kBypass) {
+      return 0;
+    }
+    stat.bkt_id_.Truncate(new_size, stat.page_size_);
     return 0;
   }
 
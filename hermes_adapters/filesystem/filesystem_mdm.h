@@ -57,6 +57,12 @@ public:
     return HERMES_CLIENT_CONF.GetAdapterConfig(path).page_size_;
   }
 
+  /** Whether a particular file is staged with O_DIRECT */
+  bool IsAdapterDirectIo(const std::string &path) {
+    ScopedRwReadLock md_lock(lock_, 4);
+    return HERMES_CLIENT_CONF.GetAdapterConfig(path).direct_io_;
+  }
+
   /**
    * Create a metadata entry for filesystem adapters given File handler.
    * @param f original file handler of the file on the destination
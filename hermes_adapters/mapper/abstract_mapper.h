@@ -36,19 +36,11 @@ struct BlobPlacement {
 
   /** create a BLOB name from index. */
   static chi::string CreateBlobName(size_t page) {
-    chi::string buf(sizeof(page));
-    hipc::LocalSerialize srl(buf);
-    srl << page;
-    return buf;
+    return GetPageBlobName(page);
   }
 
   /** create a BLOB name from index. */
-  chi::string CreateBlobName() const {
-    chi::string buf(sizeof(page_));
-    hipc::LocalSerialize srl(buf);
-    srl << page_;
-    return buf;
-  }
+  chi::string CreateBlobName() const { return GetPageBlobName(page_); }
 
   /** decode \a blob_name BLOB name to index.  */
   template<typename StringT>
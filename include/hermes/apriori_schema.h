@@ -0,0 +1,286 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_APRIORI_SCHEMA_H_
+#define HERMES_INCLUDE_HERMES_APRIORI_SCHEMA_H_
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hermes {
+
+/** An inclusive range of pages of a bucket */
+struct PageRange {
+  std::string bkt_name_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+
+  /** Whether \a page lies in the range */
+  bool Contains(size_t page) const { return begin_ <= page && page <= end_; }
+
+  bool operator==(const PageRange &other) const {
+    return bkt_name_ == other.bkt_name_ && begin_ == other.begin_ &&
+           end_ == other.end_;
+  }
+};
+
+/** Pages to stage in and the score to give them */
+struct AprioriPrefetch {
+  PageRange pages_;
+  float score_ = 1;
+
+  bool operator==(const AprioriPrefetch &other) const {
+    return pages_ == other.pages_ && score_ == other.score_;
+  }
+};
+
+/** After a read of a page in trigger_, act on prefetch_ */
+struct AprioriRule {
+  PageRange trigger_;
+  std::vector<AprioriPrefetch> prefetch_;
+};
+
+/** A page read recorded in an I/O trace */
+struct TraceRead {
+  int rank_ = 0;
+  size_t page_ = 0;
+  std::string bkt_name_;
+};
+
+/**
+ * A set of apriori prefetch rules, keyed by the bucket whose reads trigger
+ * them. Schemas are YAML lists of the form:
+ *
+ *   - bucket: /path/to/file
+ *     pages: [0, 3]
+ *     prefetch:
+ *       - bucket: /path/to/file
+ *         pages: [16, 31]
+ *         score: 1
+ *
+ * Traces are text files with one "rank page bucket" line per read.
+ * */
+class AprioriSchema {
+ private:
+  /** Rules of each trigger bucket, sorted by first trigger page */
+  std::unordered_map<std::string, std::vector<AprioriRule>> rules_;
+  size_t count_ = 0;
+
+ public:
+  /** Number of rules */
+  size_t size() const { return count_; }
+
+  /** Add a rule */
+  void AddRule(const AprioriRule &rule) {
+    std::vector<AprioriRule> &rules = rules_[rule.trigger_.bkt_name_];
+    auto it = std::upper_bound(rules.begin(), rules.end(), rule,
+                               [](const AprioriRule &a, const AprioriRule &b) {
+                                 return a.trigger_.begin_ < b.trigger_.begin_;
+                               });
+    rules.insert(it, rule);
+    ++count_;
+  }
+
+  /** Append the rules triggered by a read of \a page of \a bkt_name */
+  void Find(const std::string &bkt_name, size_t page,
+            std::vector<const AprioriRule *> &found) const {
+    auto it = rules_.find(bkt_name);
+    if (it == rules_.end()) {
+      return;
+    }
+    for (const AprioriRule &rule : it->second) {
+      if (rule.trigger_.begin_ > page) {
+        break;
+      }
+      if (rule.trigger_.Contains(page)) {
+        found.emplace_back(&rule);
+      }
+    }
+  }
+
+  /** Whether any rule is triggered by reads of \a bkt_name */
+  bool HasBucket(const std::string &bkt_name) const {
+    return rules_.find(bkt_name) != rules_.end();
+  }
+
+  /** Load rules from a YAML schema file. Returns false on error. */
+  bool Load(const std::string &path) {
+    YAML::Node yaml;
+    try {
+      yaml = YAML::LoadFile(path);
+    } catch (const YAML::Exception &e) {
+      return false;
+    }
+    for (const YAML::Node &node : yaml) {
+      AprioriRule rule;
+      ParseRange(node, rule.trigger_);
+      for (const YAML::Node &pnode : node["prefetch"]) {
+        AprioriPrefetch prefetch;
+        ParseRange(pnode, prefetch.pages_);
+        if (pnode["score"]) {
+          prefetch.score_ = pnode["score"].as<float>();
+        }
+        rule.prefetch_.emplace_back(prefetch);
+      }
+      AddRule(rule);
+    }
+    return true;
+  }
+
+  /** Write the rules as a YAML schema */
+  void Save(std::ostream &out) const {
+    YAML::Emitter yaml;
+    yaml << YAML::BeginSeq;
+    for (const auto &it : rules_) {
+      for (const AprioriRule &rule : it.second) {
+        yaml << YAML::BeginMap;
+        EmitRange(yaml, rule.trigger_);
+        yaml << YAML::Key << "prefetch" << YAML::Value << YAML::BeginSeq;
+        for (const AprioriPrefetch &prefetch : rule.prefetch_) {
+          yaml << YAML::BeginMap;
+          EmitRange(yaml, prefetch.pages_);
+          yaml << YAML::Key << "score" << YAML::Value << prefetch.score_;
+          yaml << YAML::EndMap;
+        }
+        yaml << YAML::EndSeq << YAML::EndMap;
+      }
+    }
+    yaml << YAML::EndSeq;
+    out << yaml.c_str() << std::endl;
+  }
+
+  /** Parse a "rank page bucket" line of a trace */
+  static bool ParseTraceLine(const std::string &line, TraceRead &read) {
+    std::istringstream ss(line);
+    if (!(ss >> read.rank_ >> read.page_)) {
+      return false;
+    }
+    std::getline(ss >> std::ws, read.bkt_name_);
+    return !read.bkt_name_.empty();
+  }
+
+  /** Append the reads of a trace file to \a trace */
+  static bool LoadTrace(const std::string &path,
+                        std::vector<TraceRead> &trace) {
+    std::ifstream in(path);
+    if (!in) {
+      return false;
+    }
+    std::string line;
+    TraceRead read;
+    while (std::getline(in, line)) {
+      if (ParseTraceLine(line, read)) {
+        trace.emplace_back(read);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Derive rules from a trace. Each read of a rank triggers a prefetch of
+   * the next \a lookahead distinct pages that rank read. Consecutive
+   * trigger pages of a bucket with the same prefetches share one rule.
+   * */
+  static AprioriSchema Derive(const std::vector<TraceRead> &trace,
+                              size_t lookahead, float score) {
+    typedef std::pair<std::string, size_t> Page;
+    // Split the trace by rank, dropping repeated reads of a page
+    std::map<int, std::vector<Page>> streams;
+    for (const TraceRead &read : trace) {
+      std::vector<Page> &stream = streams[read.rank_];
+      Page page(read.bkt_name_, read.page_);
+      if (stream.empty() || stream.back() != page) {
+        stream.emplace_back(page);
+      }
+    }
+    // Pages read after each trigger page
+    std::map<Page, std::set<Page>> follows;
+    for (auto &it : streams) {
+      std::vector<Page> &stream = it.second;
+      for (size_t i = 0; i < stream.size(); ++i) {
+        std::set<Page> &next = follows[stream[i]];
+        for (size_t j = i + 1;
+             j < stream.size() && j <= i + lookahead; ++j) {
+          if (stream[j] != stream[i]) {
+            next.emplace(stream[j]);
+          }
+        }
+      }
+    }
+    // Turn the followers into rules, merging neighboring triggers
+    AprioriSchema schema;
+    AprioriRule rule;
+    for (auto &it : follows) {
+      const Page &trigger = it.first;
+      if (it.second.empty()) {
+        continue;
+      }
+      std::vector<AprioriPrefetch> prefetch;
+      for (const Page &page : it.second) {
+        if (!prefetch.empty()) {
+          PageRange &last = prefetch.back().pages_;
+          if (last.bkt_name_ == page.first && last.end_ + 1 == page.second) {
+            last.end_ = page.second;
+            continue;
+          }
+        }
+        prefetch.emplace_back(
+            AprioriPrefetch{PageRange{page.first, page.second, page.second},
+                            score});
+      }
+      if (!rule.prefetch_.empty() &&
+          rule.trigger_.bkt_name_ == trigger.first &&
+          rule.trigger_.end_ + 1 == trigger.second &&
+          rule.prefetch_ == prefetch) {
+        rule.trigger_.end_ = trigger.second;
+        continue;
+      }
+      if (!rule.prefetch_.empty()) {
+        schema.AddRule(rule);
+      }
+      rule.trigger_ = PageRange{trigger.first, trigger.second, trigger.second};
+      rule.prefetch_ = prefetch;
+    }
+    if (!rule.prefetch_.empty()) {
+      schema.AddRule(rule);
+    }
+    return schema;
+  }
+
+ private:
+  /** Parse the bucket and pages of a YAML node */
+  static void ParseRange(const YAML::Node &node, PageRange &range) {
+    range.bkt_name_ = node["bucket"].as<std::string>();
+    std::vector<size_t> pages = node["pages"].as<std::vector<size_t>>();
+    range.begin_ = pages.size() > 0 ? pages[0] : 0;
+    range.end_ = pages.size() > 1 ? pages[1] : range.begin_;
+  }
+
+  /** Emit the bucket and pages of a range */
+  static void EmitRange(YAML::Emitter &yaml, const PageRange &range) {
+    yaml << YAML::Key << "bucket" << YAML::Value << range.bkt_name_;
+    yaml << YAML::Key << "pages" << YAML::Value << YAML::Flow
+         << std::vector<size_t>{range.begin_, range.end_};
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_APRIORI_SCHEMA_H_
@@ -148,6 +148,15 @@ public:
   HSHM_CROSS_FUN
   void Clear() { mdm_.TagClearBlobs(mctx_, DomainQuery::GetDynamic(), id_); }
 
+  /**
+   * Truncates a paged bucket to \a new_size bytes
+   * */
+  HSHM_CROSS_FUN
+  void Truncate(size_t new_size, size_t page_size) {
+    mdm_.TagTruncate(mctx_, DomainQuery::GetDynamic(), id_, new_size,
+                     page_size);
+  }
+
   /**
    * Destroys this bucket along with all its contents.
    * */
@@ -209,6 +218,14 @@ public:
     return Status();
   }
 
+  /**
+   * Get the ID of the blob holding \a page when the bucket is paged
+   * (e.g., a file). No runtime lookup is needed. Null if the page is out
+   * of the range of page IDs, so it must be addressed by name.
+   * */
+  HSHM_INLINE
+  BlobId GetPageId(size_t page) const { return GetPageBlobId(id_, page); }
+
   /**
    * Put \a blob_name Blob into the bucket
    * */
@@ -361,6 +378,69 @@ public:
     ShmBasePut<true, true>(chi::string(""), blob_id, blob, blob_off, ctx);
   }
 
+  /**
+   * Put many blobs into the bucket using a single task
+   *
+   * @param blob_names the names of the blobs (may be empty if IDs are set)
+   * @param[INOUT] entries the blobs to put. Blob IDs are filled in.
+   * */
+  template <bool PARTIAL, typename StringT = std::string>
+  HSHM_INLINE void ShmBasePutMany(const std::vector<StringT> &blob_names,
+                                  std::vector<BlobBatchEntry> &entries,
+                                  const Context &ctx) {
+    bitfield32_t hermes_flags;
+    if constexpr (!PARTIAL) {
+      hermes_flags.SetBits(HERMES_BLOB_REPLACE);
+    }
+    mdm_.PutBlobBatch(mctx_, DomainQuery::GetLocalHash(0), id_, blob_names,
+                      entries, ctx.blob_score_, 0, hermes_flags.bits_, ctx);
+  }
+
+  /**
+   * Put \a blobs named \a blob_names into the bucket using a single task
+   * */
+  template <typename StringT = std::string>
+  std::vector<BlobId> PutMany(const std::vector<StringT> &blob_names,
+                              std::vector<Blob> &blobs,
+                              const Context &ctx = Context()) {
+    std::vector<BlobBatchEntry> entries;
+    entries.reserve(blobs.size());
+    for (Blob &blob : blobs) {
+      entries.emplace_back(BlobId::GetNull(), 0, blob.size(), blob.shm());
+    }
+    ShmBasePutMany<false>(blob_names, entries, ctx);
+    return GetBatchIds(entries);
+  }
+
+  /**
+   * PartialPut \a blobs named \a blob_names at \a blob_offs using a single task
+   * */
+  template <typename StringT = std::string>
+  std::vector<BlobId> PartialPutMany(const std::vector<StringT> &blob_names,
+                                     std::vector<Blob> &blobs,
+                                     const std::vector<size_t> &blob_offs,
+                                     const Context &ctx = Context()) {
+    std::vector<BlobBatchEntry> entries;
+    entries.reserve(blobs.size());
+    for (size_t i = 0; i < blobs.size(); ++i) {
+      entries.emplace_back(BlobId::GetNull(), blob_offs[i], blobs[i].size(),
+                           blobs[i].shm());
+    }
+    ShmBasePutMany<true>(blob_names, entries, ctx);
+    return GetBatchIds(entries);
+  }
+
+  /** Collect the blob IDs of a completed batch */
+  static std::vector<BlobId> GetBatchIds(
+      const std::vector<BlobBatchEntry> &entries) {
+    std::vector<BlobId> blob_ids;
+    blob_ids.reserve(entries.size());
+    for (const BlobBatchEntry &entry : entries) {
+      blob_ids.emplace_back(entry.blob_id_);
+    }
+    return blob_ids;
+  }
+
   /**
    * Put \a blob_name Blob into the bucket
    * */
@@ -612,6 +692,70 @@ public:
     return ShmAsyncBaseGet(chi::string(""), blob_id, blob, blob_off, ctx);
   }
 
+  /**
+   * Get many blobs from the bucket using a single task
+   *
+   * @param blob_names the names of the blobs (may be empty if IDs are set)
+   * @param[INOUT] entries the blobs to get. Blob IDs and sizes are filled in.
+   * */
+  template <typename StringT = std::string>
+  HSHM_INLINE void ShmBaseGetMany(const std::vector<StringT> &blob_names,
+                                  std::vector<BlobBatchEntry> &entries,
+                                  const Context &ctx) {
+    mdm_.GetBlobBatch(mctx_, DomainQuery::GetLocalHash(0), id_, blob_names,
+                      entries, 0, ctx);
+  }
+
+  /**
+   * Get \a blobs named \a blob_names from the bucket using a single task.
+   * Blobs which are not yet allocated are sized to the current blob size.
+   * */
+  template <typename StringT = std::string>
+  std::vector<BlobId> GetMany(const std::vector<StringT> &blob_names,
+                              std::vector<Blob> &blobs,
+                              const Context &ctx = Context()) {
+    return PartialGetMany(blob_names, blobs,
+                          std::vector<size_t>(blob_names.size(), 0), ctx);
+  }
+
+  /**
+   * PartialGet \a blobs named \a blob_names at \a blob_offs using a single task
+   * */
+  template <typename StringT = std::string>
+  std::vector<BlobId> PartialGetMany(const std::vector<StringT> &blob_names,
+                                     std::vector<Blob> &blobs,
+                                     const std::vector<size_t> &blob_offs,
+                                     const Context &ctx = Context()) {
+    blobs.resize(blob_names.size());
+    // Size the blobs which are not yet allocated in one batch
+    std::vector<size_t> unsized;
+    std::vector<StringT> unsized_names;
+    std::vector<BlobBatchEntry> entries;
+    for (size_t i = 0; i < blobs.size(); ++i) {
+      if (blobs[i].data_.shm_.IsNull()) {
+        unsized.emplace_back(i);
+        unsized_names.emplace_back(blob_names[i]);
+        entries.emplace_back(BlobId::GetNull(), 0, 0, hipc::Pointer::GetNull());
+      }
+    }
+    if (!unsized.empty()) {
+      mdm_.GetBlobBatch(mctx_, DomainQuery::GetLocalHash(0), id_,
+                        unsized_names, entries, HERMES_GET_BLOB_SIZE, ctx);
+      for (size_t i = 0; i < unsized.size(); ++i) {
+        blobs[unsized[i]].resize(entries[i].data_size_);
+      }
+      entries.clear();
+    }
+    entries.reserve(blobs.size());
+    for (size_t i = 0; i < blobs.size(); ++i) {
+      Blob &blob = blobs[i];
+      entries.emplace_back(BlobId::GetNull(), blob_offs[i], blob.size(),
+                           blob.shm());
+    }
+    ShmBaseGetMany(blob_names, entries, ctx);
+    return GetBatchIds(entries);
+  }
+
   /**
    * Determine if the bucket contains \a blob_id BLOB
    * */
@@ -640,6 +784,16 @@ public:
     mdm_.DestroyBlob(mctx_, DomainQuery::GetDynamic(), id_, blob_id);
   }
 
+  /**
+   * Truncate \a blob_id blob to \a new_size bytes
+   * */
+  HSHM_CROSS_FUN
+  void TruncateBlob(const BlobId &blob_id, size_t new_size,
+                    const Context &ctx = Context()) {
+    mdm_.TruncateBlob(mctx_, DomainQuery::GetDynamic(), id_, blob_id,
+                      new_size);
+  }
+
   /**
    * Get the set of blob IDs contained in the bucket
    * */
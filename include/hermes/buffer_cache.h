@@ -0,0 +1,163 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_BUFFER_CACHE_H_
+#define HERMES_INCLUDE_HERMES_BUFFER_CACHE_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/**
+ * A cache of free blocks of one target, owned by a single lane.
+ *
+ * Blocks are binned by the device's slab sizes. Taking and returning
+ * blocks only touches the cache; the owner refills it from the bdev
+ * in batches of GetRefillSize() bytes and drains it back to the bdev
+ * once more than GetMaxCached() bytes are idle. Refills are bounded by
+ * the cache's share of the target, so idle blocks of all lanes together
+ * never hold more than a fraction of it.
+ * */
+class BufferCache {
+ public:
+  CLS_CONST size_t kRefillSlabs = 4; /**< Largest slabs fetched per refill */
+  CLS_CONST size_t kMaxRefills = 4;  /**< Refills held before draining */
+  CLS_CONST size_t kTargetShare = 8; /**< All caches hold <= 1/8 of a target */
+
+ private:
+  std::vector<size_t> slab_sizes_;            /**< Sorted slab sizes */
+  std::vector<std::vector<chi::Block>> free_; /**< Free blocks per slab */
+  size_t cached_ = 0;                         /**< Bytes in the cache */
+  size_t refill_size_ = 0;                    /**< Bytes per refill */
+
+ public:
+  size_t drain_epoch_ = 0; /**< Last drain request of the target handled */
+
+  /** Default constructor */
+  BufferCache() : BufferCache(std::vector<size_t>()) {}
+
+  /**
+   * Construct from the slab sizes of a device. \a max_cached bounds the
+   * idle bytes of the cache (0 for no bound).
+   * */
+  explicit BufferCache(const std::vector<size_t> &slab_sizes,
+                       size_t block_size = KILOBYTES(4),
+                       size_t max_cached = 0) {
+    slab_sizes_ = slab_sizes;
+    if (slab_sizes_.empty()) {
+      slab_sizes_.emplace_back(block_size);
+    }
+    std::sort(slab_sizes_.begin(), slab_sizes_.end());
+    free_.resize(slab_sizes_.size());
+    refill_size_ = slab_sizes_.back() * kRefillSlabs;
+    if (max_cached > 0) {
+      refill_size_ = std::min(refill_size_, max_cached / kMaxRefills);
+    }
+  }
+
+  /**
+   * The idle bytes one of \a num_caches caches of a target of \a max_cap
+   * bytes may hold
+   * */
+  static size_t GetCacheShare(size_t max_cap, size_t num_caches) {
+    return max_cap / (std::max<size_t>(num_caches, 1) * kTargetShare);
+  }
+
+  /** Bytes currently cached */
+  size_t GetCached() const { return cached_; }
+
+  /** Bytes to request from the bdev per refill */
+  size_t GetRefillSize() const { return refill_size_; }
+
+  /** Bytes the cache may hold before it should be drained */
+  size_t GetMaxCached() const { return refill_size_ * kMaxRefills; }
+
+  /** Whether the cache holds too many idle bytes */
+  bool NeedsDrain() const { return cached_ > GetMaxCached(); }
+
+  /** Return a block to the cache */
+  void Put(const chi::Block &block) {
+    if (block.size_ == 0) {
+      return;
+    }
+    free_[GetSlab(block.size_)].emplace_back(block);
+    cached_ += block.size_;
+  }
+
+  /**
+   * Take blocks totaling at least \a size bytes, preferring the smallest
+   * slab that covers what remains. Returns the number of bytes taken, which
+   * is less than \a size if the cache runs dry.
+   * */
+  size_t Take(size_t size, std::vector<chi::Block> &blocks) {
+    size_t taken = 0;
+    while (taken < size) {
+      int slab = PickSlab(size - taken);
+      if (slab < 0) {
+        break;
+      }
+      chi::Block block = free_[slab].back();
+      free_[slab].pop_back();
+      cached_ -= block.size_;
+      taken += block.size_;
+      blocks.emplace_back(block);
+    }
+    return taken;
+  }
+
+  /** Remove blocks until at most \a keep bytes remain cached */
+  void Drain(size_t keep, std::vector<chi::Block> &blocks) {
+    for (int slab = (int)free_.size() - 1; slab >= 0; --slab) {
+      std::vector<chi::Block> &bin = free_[slab];
+      while (cached_ > keep && !bin.empty()) {
+        cached_ -= bin.back().size_;
+        blocks.emplace_back(bin.back());
+        bin.pop_back();
+      }
+    }
+  }
+
+ private:
+  /** The largest slab not bigger than \a size (or the smallest slab) */
+  size_t GetSlab(size_t size) const {
+    auto it = std::upper_bound(slab_sizes_.begin(), slab_sizes_.end(), size);
+    if (it == slab_sizes_.begin()) {
+      return 0;
+    }
+    return (it - slab_sizes_.begin()) - 1;
+  }
+
+  /**
+   * The smallest non-empty slab covering \a size, or else the largest
+   * non-empty slab. -1 if the cache is empty.
+   * */
+  int PickSlab(size_t size) const {
+    int largest = -1;
+    for (size_t slab = 0; slab < free_.size(); ++slab) {
+      if (free_[slab].empty()) {
+        continue;
+      }
+      if (slab_sizes_[slab] >= size) {
+        return (int)slab;
+      }
+      largest = (int)slab;
+    }
+    return largest;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_BUFFER_CACHE_H_
@@ -75,8 +75,18 @@ struct BorgInfo {
   int num_threads_;
   /** Interval (seconds) where blobs are checked for flushing */
   size_t flush_period_;
-  /** Interval (seconds) where blobs are checked for re-organization */
+  /** Max bytes of contiguous pages merged into one flush write */
+  size_t flush_max_bytes_;
+  /** Max bytes of flush writes submitted to a stager as one batch */
+  size_t flush_batch_bytes_;
+  /** Interval (ms) where blobs are checked for re-organization */
   size_t blob_reorg_period_;
+  /** Max bytes the node migrates per re-organization period */
+  size_t blob_reorg_max_bytes_;
+  /** Blob score change required before a blob is moved */
+  float blob_reorg_min_delta_;
+  /** Factor access counts are multiplied by every period */
+  float freq_decay_;
   /** Time when score is equal to 1 (seconds) */
   float recency_min_;
   /** Time when score is equal to 0 (seconds) */
@@ -96,6 +106,8 @@ struct PrefetchInfo {
   std::string apriori_schema_path_;
   size_t epoch_ms_;
   bool is_mpi_;
+  /** Max pages staged in ahead of a sequential or strided reader */
+  size_t read_ahead_max_;
 };
 
 /**
@@ -232,9 +244,28 @@ class ServerConfig : public BaseConfig {
     if (yaml_conf["flush_period"]) {
       borg_.flush_period_ = yaml_conf["flush_period"].as<size_t>();
     }
+    if (yaml_conf["flush_max_bytes"]) {
+      borg_.flush_max_bytes_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["flush_max_bytes"].as<std::string>());
+    }
+    if (yaml_conf["flush_batch_bytes"]) {
+      borg_.flush_batch_bytes_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["flush_batch_bytes"].as<std::string>());
+    }
     if (yaml_conf["blob_reorg_period"]) {
       borg_.blob_reorg_period_ = yaml_conf["blob_reorg_period"].as<size_t>();
     }
+    if (yaml_conf["blob_reorg_max_bytes"]) {
+      borg_.blob_reorg_max_bytes_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["blob_reorg_max_bytes"].as<std::string>());
+    }
+    if (yaml_conf["blob_reorg_min_delta"]) {
+      borg_.blob_reorg_min_delta_ =
+          yaml_conf["blob_reorg_min_delta"].as<float>();
+    }
+    if (yaml_conf["freq_decay"]) {
+      borg_.freq_decay_ = yaml_conf["freq_decay"].as<float>();
+    }
     if (yaml_conf["recency_min"]) {
       borg_.recency_min_ = yaml_conf["recency_min"].as<float>();
     }
@@ -250,7 +281,7 @@ class ServerConfig : public BaseConfig {
   }
 
   /** parse I/O tracing information from YAML config */
-  void ParsePrefetchInfo(YAML::Node yaml_conf) {
+  void ParseTracingInfo(YAML::Node yaml_conf) {
     if (yaml_conf["enabled"]) {
       tracing_.enabled_ = yaml_conf["enabled"].as<bool>();
     }
@@ -261,7 +292,7 @@ class ServerConfig : public BaseConfig {
   }
 
   /** parse prefetch information from YAML config */
-  void ParseTracingInfo(YAML::Node yaml_conf) {
+  void ParsePrefetchInfo(YAML::Node yaml_conf) {
     if (yaml_conf["enabled"]) {
       prefetcher_.enabled_ = yaml_conf["enabled"].as<bool>();
     }
@@ -275,6 +306,9 @@ class ServerConfig : public BaseConfig {
     if (yaml_conf["is_mpi"]) {
       prefetcher_.is_mpi_ = yaml_conf["is_mpi"].as<bool>();
     }
+    if (yaml_conf["read_ahead_max"]) {
+      prefetcher_.read_ahead_max_ = yaml_conf["read_ahead_max"].as<size_t>();
+    }
     if (yaml_conf["apriori_schema_path"]) {
       prefetcher_.apriori_schema_path_ =
           yaml_conf["apriori_schema_path"].as<std::string>();
@@ -284,7 +318,7 @@ class ServerConfig : public BaseConfig {
   /** parse prefetch information from YAML config */
   void ParseMdmInfo(YAML::Node yaml_conf) {
     mdm_.num_blobs_ = yaml_conf["est_blob_count"].as<size_t>();
-    mdm_.num_bkts_ = yaml_conf["est_blob_count"].as<size_t>();
+    mdm_.num_bkts_ = yaml_conf["est_bucket_count"].as<size_t>();
     mdm_.num_traits_ = yaml_conf["est_num_traits"].as<size_t>();
   }
 };
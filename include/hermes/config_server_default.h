@@ -81,9 +81,21 @@ const inline char* kHermesServerDefaultConfigStr =
 "  # Interval (ms) where blobs are checked for flushing\n"
 "  flush_period: 1024\n"
 "\n"
+"  # Max amount of contiguous dirty pages merged into one flush write\n"
+"  flush_max_bytes: 16MB\n"
+"\n"
+"  # Max amount of flush writes submitted to a stager as one batch\n"
+"  flush_batch_bytes: 64MB\n"
+"\n"
 "  # Interval (ms) where blobs are checked for re-organization\n"
 "  blob_reorg_period: 1024\n"
 "\n"
+"  # Max amount of data the node migrates per re-organization period\n"
+"  blob_reorg_max_bytes: 64MB\n"
+"\n"
+"  # Score change a blob needs before it is moved to another tier\n"
+"  blob_reorg_min_delta: 0.1\n"
+"\n"
 "  ## What does \"recently accessed\" mean?\n"
 "  # Time when score is equal to 1 (seconds)\n"
 "  recency_min: 0\n"
@@ -95,6 +107,8 @@ const inline char* kHermesServerDefaultConfigStr =
 "  freq_max: 15\n"
 "  # Number of accesses for score to be equal to 0 (count)\n"
 "  freq_min: 0\n"
+"  # Factor access counts are multiplied by every re-organization period\n"
+"  freq_decay: 0.5\n"
 "\n"
 "### Define the default data placement policy\n"
 "dpe:\n"
@@ -113,10 +127,15 @@ const inline char* kHermesServerDefaultConfigStr =
 "### Define prefetcher properties\n"
 "prefetch:\n"
 "  enabled: false\n"
+"  # Record page reads to this path (suffixed by node id) for\n"
+"  # hermes_apriori_schema\n"
 "  io_trace_path: \"\"\n"
+"  # Prefetch rules derived by hermes_apriori_schema\n"
 "  apriori_schema_path: \"\"\n"
 "  epoch_ms: 50\n"
 "  is_mpi: false\n"
+"  # Max pages staged in ahead of a sequential or strided reader\n"
+"  read_ahead_max: 32\n"
 "\n"
 "### Define mdm properties\n"
 "mdm:\n"
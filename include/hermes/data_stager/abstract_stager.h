@@ -9,6 +9,18 @@
 
 namespace hermes {
 
+/** A read or write of part of a page blob, run by Submit and Reap */
+struct StageIo {
+  std::string blob_name_;
+  size_t blob_off_ = 0;
+  hipc::Pointer data_;
+  size_t size_ = 0;
+  bool is_read_ = false;
+  ssize_t result_ = 0; /**< Bytes moved, or negative on error */
+  bool submitted_ = false;
+  bool done_ = false;
+};
+
 class AbstractStager {
  public:
   std::string path_;
@@ -20,15 +32,56 @@ class AbstractStager {
   virtual void RegisterStager(const hipc::MemContext &mctx,
                               const std::string &tag_name,
                               const std::string &params) = 0;
+  /**
+   * Put bytes [blob_off, blob_off + data_size) of a page blob from the
+   * backend. A data_size of 0 stages in the rest of the page.
+   * */
   virtual void StageIn(const hipc::MemContext &mctx, hermes::Client &client,
                        const TagId &tag_id, const std::string &blob_name,
-                       float score) = 0;
+                       size_t blob_off, size_t data_size, float score) = 0;
+  /** Write \a data_size bytes at \a blob_off of a page blob to the backend */
   virtual void StageOut(const hipc::MemContext &mctx, hermes::Client &client,
                         const TagId &tag_id, const std::string &blob_name,
-                        hipc::Pointer &data_p, size_t data_size) = 0;
+                        size_t blob_off, hipc::Pointer &data_p,
+                        size_t data_size) = 0;
   virtual void UpdateSize(const hipc::MemContext &mctx, hermes::Client &client,
                           const TagId &tag_id, const std::string &blob_name,
                           size_t blob_off, size_t data_size) = 0;
+  virtual void Truncate(const hipc::MemContext &mctx, hermes::Client &client,
+                        const TagId &tag_id, size_t new_size) = 0;
+  /** Bytes per page, or 0 if pages cannot be merged into one write */
+  virtual size_t GetPageSize() { return 0; }
+  /** Read \a io from the backend. Returns false if reads are unsupported. */
+  virtual bool ReadIo(StageIo &io) { return false; }
+  /** Write \a io to the backend */
+  virtual void WriteIo(const hipc::MemContext &mctx, hermes::Client &client,
+                       const TagId &tag_id, StageIo &io) {
+    StageOut(mctx, client, tag_id, io.blob_name_, io.blob_off_, io.data_,
+             io.size_);
+    io.result_ = (ssize_t)io.size_;
+  }
+  /**
+   * Start a batch of reads and writes. Stagers with asynchronous I/O
+   * return at once and complete the batch in Reap, so one worker can keep
+   * many I/Os in flight. By default the batch is run here, one I/O at a
+   * time.
+   * */
+  virtual void Submit(const hipc::MemContext &mctx, hermes::Client &client,
+                      const TagId &tag_id, std::vector<StageIo> &ios) {
+    for (StageIo &io : ios) {
+      if (io.is_read_) {
+        if (!ReadIo(io)) {
+          io.result_ = -1;
+        }
+      } else {
+        WriteIo(mctx, client, tag_id, io);
+      }
+      io.submitted_ = true;
+      io.done_ = true;
+    }
+  }
+  /** Collect finished I/Os. Returns true once all of \a ios are done. */
+  virtual bool Reap(std::vector<StageIo> &ios) { return true; }
 };
 
 }  // namespace hermes
@@ -5,6 +5,8 @@
 #ifndef HERMES_TASKS_DATA_STAGER_SRC_BINARY_STAGER_H_
 #define HERMES_TASKS_DATA_STAGER_SRC_BINARY_STAGER_H_
 
+#include <mutex>
+
 #include "abstract_stager.h"
 #include "hermes_adapters/mapper/abstract_mapper.h"
 
@@ -15,13 +17,34 @@ public:
   size_t page_size_;
   std::string path_;
   bitfield32_t flags_;
+  int fd_ = -1;        /**< Backend fd, kept open while registered */
+  std::mutex fd_lock_; /**< Guards opening fd_ */
 
 public:
   /** Default constructor */
   BinaryFileStager() = default;
 
-  /** Destructor */
-  ~BinaryFileStager() {}
+  /** Destructor. Runs once the stager is unregistered and unused. */
+  ~BinaryFileStager() {
+    if (fd_ >= 0) {
+      HERMES_POSIX_API->close(fd_);
+    }
+  }
+
+  /**
+   * Open the backend file on first use. The fd is shared by all I/O of
+   * the stager, which only uses positional pread/pwrite on it.
+   * */
+  int GetFd() {
+    std::lock_guard<std::mutex> lock(fd_lock_);
+    if (fd_ < 0) {
+      fd_ = HERMES_POSIX_API->open(path_.c_str(), O_CREAT | O_RDWR, 0666);
+      if (fd_ < 0) {
+        HELOG(kError, "Failed to open file {}", path_);
+      }
+    }
+    return fd_;
+  }
 
   /** Build context for staging */
   static Context BuildContext(size_t page_size, u32 flags = 0,
@@ -58,71 +81,95 @@ public:
   /** Stage data in from remote source */
   void StageIn(const hipc::MemContext &mctx, hermes::Client &client,
                const TagId &tag_id, const std::string &blob_name,
-               float score) override {
-    if (flags_.Any(HERMES_STAGE_NO_READ)) {
+               size_t blob_off, size_t data_size, float score) override {
+    if (flags_.Any(HERMES_STAGE_NO_READ) || blob_off >= page_size_) {
       return;
     }
-    // Get the position of the file to stage in
-    adapter::BlobPlacement plcmnt;
-    plcmnt.DecodeBlobName(blob_name, page_size_);
+    if (data_size == 0 || blob_off + data_size > page_size_) {
+      data_size = page_size_ - blob_off;
+    }
+    // Stage in the data from the file
+    StageIo io;
+    io.blob_name_ = blob_name;
+    io.blob_off_ = blob_off;
+    io.size_ = data_size;
+    io.is_read_ = true;
     HILOG(kDebug,
           "Attempting to stage {} bytes from the backend file {} at offset {}",
-          page_size_, path_, plcmnt.bucket_off_);
-    // Stage in the data from the file
-    FullPtr<char> blob = CHI_CLIENT->AllocateBuffer(mctx, page_size_);
-    int fd = HERMES_POSIX_API->open(path_.c_str(), O_CREAT | O_RDWR, 0666);
-    if (fd < 0) {
-      HELOG(kError, "Failed to open file {}", path_);
-      CHI_CLIENT->FreeBuffer(HSHM_MCTX, blob);
-      return;
-    }
-    ssize_t real_size = HERMES_POSIX_API->pread(fd, blob.ptr_, page_size_,
-                                                (off_t)plcmnt.bucket_off_);
-    HERMES_POSIX_API->close(fd);
+          data_size, path_, GetFileOff(io));
+    FullPtr<char> blob = CHI_CLIENT->AllocateBuffer(mctx, data_size);
+    io.data_ = blob.shm_;
+    ReadIo(io);
+    ssize_t real_size = io.result_;
     // Verify the data was staged in
-    if (real_size < 0) {
-      CHI_CLIENT->FreeBuffer(HSHM_MCTX, blob);
-      return;
-    } else if (real_size == 0) {
+    if (real_size <= 0) {
       CHI_CLIENT->FreeBuffer(HSHM_MCTX, blob);
       return;
     }
     // Put the new blob into hermes
     HILOG(kDebug, "Staged {} bytes from the backend file {}", real_size, path_);
     client.PutBlob(mctx, chi::DomainQuery::GetDynamic(), tag_id,
-                   chi::string(blob_name), hermes::BlobId::GetNull(), 0,
-                   real_size, blob.shm_, score, TASK_DATA_OWNER, 0);
+                   chi::string(blob_name), hermes::BlobId::GetNull(),
+                   blob_off, real_size, blob.shm_, score, TASK_DATA_OWNER,
+                   HERMES_IS_STAGE_IN);
   }
 
   /** Stage data out to remote source */
   void StageOut(const hipc::MemContext &mctx, hermes::Client &client,
                 const TagId &tag_id, const std::string &blob_name,
-                hipc::Pointer &data_p, size_t data_size) override {
+                size_t blob_off, hipc::Pointer &data_p,
+                size_t data_size) override {
     if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
       return;
     }
-    // Get the position of the file to stage out
-    adapter::BlobPlacement plcmnt;
-    plcmnt.DecodeBlobName(blob_name, page_size_);
-    HILOG(kDebug,
-          "Attempting to stage {} bytes to the backend file {} at offset {}",
-          page_size_, path_, plcmnt.bucket_off_);
     // Stage out the data to the file
-    FullPtr data(data_p);
-    int fd = HERMES_POSIX_API->open(path_.c_str(), O_CREAT | O_RDWR, 0666);
-    if (fd < 0) {
-      HELOG(kError, "Failed to open file {}", path_);
+    StageIo io;
+    io.blob_name_ = blob_name;
+    io.blob_off_ = blob_off;
+    io.data_ = data_p;
+    io.size_ = data_size;
+    WriteIo(mctx, client, tag_id, io);
+    HILOG(kDebug, "Staged out {} bytes to the backend file {} at offset {}",
+          io.result_, path_, GetFileOff(io));
+  }
+
+  /** The backend bytes covered by each page */
+  size_t GetPageSize() override { return page_size_; }
+
+  /** The backend offset of \a io */
+  off_t GetFileOff(const StageIo &io) {
+    adapter::BlobPlacement plcmnt;
+    plcmnt.DecodeBlobName(io.blob_name_, page_size_);
+    return (off_t)(plcmnt.bucket_off_ + io.blob_off_);
+  }
+
+  /** Read \a io from the backend file */
+  bool ReadIo(StageIo &io) override {
+    int fd = GetFd();
+    if (flags_.Any(HERMES_STAGE_NO_READ) || fd < 0) {
+      io.result_ = 0;
+      return true;
+    }
+    FullPtr<char> data(io.data_);
+    io.result_ = HERMES_POSIX_API->pread(fd, data.ptr_, io.size_,
+                                         GetFileOff(io));
+    return true;
+  }
+
+  /** Write \a io to the backend file */
+  void WriteIo(const hipc::MemContext &mctx, hermes::Client &client,
+               const TagId &tag_id, StageIo &io) override {
+    int fd = GetFd();
+    if (flags_.Any(HERMES_STAGE_NO_WRITE) || fd < 0) {
+      io.result_ = 0;
       return;
     }
-    ssize_t real_size = HERMES_POSIX_API->pwrite(fd, data.ptr_, data_size,
-                                                 (off_t)plcmnt.bucket_off_);
-    HERMES_POSIX_API->close(fd);
-    // Verify the data was staged out
-    if (real_size < 0) {
-      HELOG(kError, "Failed to stage out {} bytes from {}", data_size, path_);
+    FullPtr<char> data(io.data_);
+    io.result_ = HERMES_POSIX_API->pwrite(fd, data.ptr_, io.size_,
+                                          GetFileOff(io));
+    if (io.result_ < 0) {
+      HELOG(kError, "Failed to stage out {} bytes to {}", io.size_, path_);
     }
-    HILOG(kDebug, "Staged out {} bytes to the backend file {}", real_size,
-          path_);
   }
 
   void UpdateSize(const hipc::MemContext &mctx, hermes::Client &client,
@@ -134,6 +181,21 @@ public:
                               p.bucket_off_ + blob_off + data_size,
                               UpdateSizeMode::kCap);
   }
+
+  /** Truncate the backend file so dropped pages are not staged back in */
+  void Truncate(const hipc::MemContext &mctx, hermes::Client &client,
+                const TagId &tag_id, size_t new_size) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
+      return;
+    }
+    int fd = GetFd();
+    if (fd < 0) {
+      return;
+    }
+    if (HERMES_POSIX_API->ftruncate(fd, (off_t)new_size) < 0) {
+      HELOG(kError, "Failed to truncate {} to {} bytes", path_, new_size);
+    }
+  }
 };
 
 } // namespace hermes
@@ -0,0 +1,374 @@
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_COMPRESS_STAGER_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_COMPRESS_STAGER_H_
+
+#include <lz4.h>
+#include <sys/stat.h>
+#include <zstd.h>
+
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "binary_stager.h"
+
+namespace hermes {
+
+/** Where a staged-out page lives in the backend file */
+struct CompressedPage {
+  u64 off_ = 0;   /**< Offset of the stored page in the backend file */
+  u32 csize_ = 0; /**< Stored bytes. Equal to size_ if stored raw. */
+  u32 size_ = 0;  /**< Bytes of the page. 0 if never staged out. */
+};
+
+/** The header of a page index file */
+struct CompressIndexHeader {
+  u32 magic_;
+  u32 codec_;
+  u64 page_size_;
+};
+
+/**
+ * A file stager that compresses each page before writing it. Pages are
+ * appended to the backend file and a sidecar index (path + ".hidx") maps
+ * each page to its stored extent, so pages can be staged in one at a time.
+ * Pages are compressed by the worker flushing them, so lanes compress in
+ * parallel. A rewritten page is appended again and the space of its old
+ * version is only reclaimed when the file is truncated to 0.
+ * */
+class CompressStager : public BinaryFileStager {
+ public:
+  enum class Codec : u32 { kLz4 = 1, kZstd = 2 };
+  CLS_CONST u32 kIndexMagic = 0x48434958;
+  CLS_CONST size_t kPageLocks = 64;
+
+ private:
+  Codec codec_ = Codec::kLz4;
+  int level_ = 0;             /**< Codec level. 0 is the codec default. */
+  std::string index_path_;
+  int index_fd_ = -1;
+  bool index_loaded_ = false; /**< Whether OpenIndex already ran */
+  bool index_ok_ = false;     /**< Whether the index loaded and matches */
+  std::vector<CompressedPage> index_;
+  u64 tail_ = 0;              /**< End of the data in the backend file */
+  std::mutex index_lock_;     /**< Guards index_ and tail_ */
+  std::mutex page_locks_[kPageLocks]; /**< Serialize writes of a page */
+
+ public:
+  /** Default constructor */
+  CompressStager() = default;
+
+  /** Destructor */
+  ~CompressStager() {
+    if (index_fd_ >= 0) {
+      HERMES_POSIX_API->close(index_fd_);
+    }
+  }
+
+  /** Build context for staging */
+  static Context BuildContext(size_t page_size,
+                              const std::string &codec = "lz4",
+                              u32 flags = 0, size_t elmt_size = 1,
+                              int level = 0) {
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    ctx.bkt_params_ =
+        BuildFileParams(page_size, codec, flags, elmt_size, level);
+    return ctx;
+  }
+
+  /** Build serialized file parameter pack. \a codec is lz4 or zstd. */
+  static std::string BuildFileParams(size_t page_size,
+                                     const std::string &codec = "lz4",
+                                     u32 flags = 0, size_t elmt_size = 1,
+                                     int level = 0) {
+    chi::string params(32);
+    page_size = (page_size / elmt_size) * elmt_size;
+    hipc::LocalSerialize srl(params);
+    srl << (std::string("file+") + codec);
+    srl << flags;
+    srl << page_size;
+    srl << level;
+    return params.str();
+  }
+
+  /** Create the data stager payload */
+  void RegisterStager(const hipc::MemContext &mctx, const std::string &tag_name,
+                      const std::string &params) override {
+    std::string protocol;
+    hipc::LocalDeserialize srl(params);
+    srl >> protocol;
+    srl >> flags_.bits_;
+    srl >> page_size_;
+    srl >> level_;
+    path_ = tag_name;
+    index_path_ = path_ + ".hidx";
+    codec_ = protocol == "file+zstd" ? Codec::kZstd : Codec::kLz4;
+    if (page_size_ > std::numeric_limits<u32>::max()) {
+      HELOG(kError, "Page size {} of {} does not fit the page index",
+            page_size_, path_);
+      page_size_ = 0;
+    }
+  }
+
+  /** Read and decompress the page holding \a io */
+  bool ReadIo(StageIo &io) override {
+    if (flags_.Any(HERMES_STAGE_NO_READ)) {
+      io.result_ = 0;
+      return true;
+    }
+    if (page_size_ == 0 || !OpenIndex()) {
+      io.result_ = -1;
+      return true;
+    }
+    adapter::BlobPlacement plcmnt;
+    plcmnt.DecodeBlobName(io.blob_name_, page_size_);
+    std::vector<char> raw;
+    if (!ReadPage(plcmnt.page_, raw)) {
+      HELOG(kError, "Failed to read page {} of {}", plcmnt.page_, path_);
+      io.result_ = -1;
+      return true;
+    }
+    if (io.blob_off_ >= raw.size()) {
+      io.result_ = 0;
+      return true;
+    }
+    size_t count = std::min(io.size_, raw.size() - io.blob_off_);
+    FullPtr<char> data(io.data_);
+    memcpy(data.ptr_, raw.data() + io.blob_off_, count);
+    io.result_ = (ssize_t)count;
+    return true;
+  }
+
+  /** Compress and append the pages covered by \a io */
+  void WriteIo(const hipc::MemContext &mctx, hermes::Client &client,
+               const TagId &tag_id, StageIo &io) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
+      io.result_ = 0;
+      return;
+    }
+    io.result_ = -1;
+    if (!OpenIndex() || page_size_ == 0) {
+      HELOG(kError, "Failed to stage out {} bytes to {}", io.size_, path_);
+      return;
+    }
+    adapter::BlobPlacement plcmnt;
+    plcmnt.DecodeBlobName(io.blob_name_, page_size_);
+    FullPtr<char> data(io.data_);
+    // Merged runs of pages are split back into pages
+    size_t page = plcmnt.page_;
+    size_t off = io.blob_off_;
+    size_t done = 0;
+    while (done < io.size_ && off < page_size_) {
+      size_t count = std::min(page_size_ - off, io.size_ - done);
+      if (!WritePart(page, off, data.ptr_ + done, count)) {
+        HELOG(kError, "Failed to stage out page {} to {}", page, path_);
+        return;
+      }
+      done += count;
+      off = 0;
+      ++page;
+    }
+    io.result_ = (ssize_t)done;
+  }
+
+  /** Drop the pages past \a new_size and cut the last page short */
+  void Truncate(const hipc::MemContext &mctx, hermes::Client &client,
+                const TagId &tag_id, size_t new_size) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE) || !OpenIndex() ||
+        page_size_ == 0) {
+      return;
+    }
+    size_t page = new_size / page_size_;
+    size_t off = new_size % page_size_;
+    if (off > 0) {
+      std::lock_guard<std::mutex> lock(GetPageLock(page));
+      std::vector<char> raw;
+      if (ReadPage(page, raw) && raw.size() > off) {
+        WritePage(page, raw.data(), off);
+      }
+      ++page;
+    }
+    std::lock_guard<std::mutex> lock(index_lock_);
+    if (index_.size() > page) {
+      index_.resize(page);
+      off_t size =
+          sizeof(CompressIndexHeader) + page * sizeof(CompressedPage);
+      HERMES_POSIX_API->ftruncate(index_fd_, size);
+    }
+    if (new_size == 0) {
+      HERMES_POSIX_API->ftruncate(GetFd(), 0);
+      tail_ = 0;
+    }
+  }
+
+ private:
+  /**
+   * Open the backend file and load the page index on first use. A failure
+   * is logged once and then fails every I/O, since pages cannot be found
+   * without the index.
+   * */
+  bool OpenIndex() {
+    int fd = GetFd();
+    std::lock_guard<std::mutex> lock(index_lock_);
+    if (index_loaded_ || fd < 0) {
+      return index_ok_;
+    }
+    index_loaded_ = true;
+    index_ok_ = LoadIndex(fd);
+    if (!index_ok_) {
+      HELOG(kError, "Failed to load the page index {}, I/O to {} will fail",
+            index_path_, path_);
+    }
+    return index_ok_;
+  }
+
+  /** Open the index file and read it, or start it (index lock held) */
+  bool LoadIndex(int fd) {
+    index_fd_ =
+        HERMES_POSIX_API->open(index_path_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (index_fd_ < 0) {
+      return false;
+    }
+    struct stat st;
+    if (HERMES_POSIX_API->fstat(fd, &st) < 0) {
+      return false;
+    }
+    tail_ = (u64)st.st_size;
+    CompressIndexHeader hdr;
+    ssize_t ret = HERMES_POSIX_API->pread(index_fd_, &hdr, sizeof(hdr), 0);
+    if (ret == 0) {
+      hdr = CompressIndexHeader{kIndexMagic, (u32)codec_, page_size_};
+      ret = HERMES_POSIX_API->pwrite(index_fd_, &hdr, sizeof(hdr), 0);
+      return ret == sizeof(hdr);
+    }
+    if (ret != sizeof(hdr) || hdr.magic_ != kIndexMagic ||
+        hdr.codec_ != (u32)codec_ || hdr.page_size_ != page_size_) {
+      HELOG(kError, "The page index {} does not match the bucket params",
+            index_path_);
+      return false;
+    }
+    if (HERMES_POSIX_API->fstat(index_fd_, &st) < 0) {
+      return false;
+    }
+    index_.resize((st.st_size - sizeof(hdr)) / sizeof(CompressedPage));
+    size_t bytes = index_.size() * sizeof(CompressedPage);
+    ret = HERMES_POSIX_API->pread(index_fd_, index_.data(), bytes,
+                                  sizeof(hdr));
+    return ret == (ssize_t)bytes;
+  }
+
+  /** The lock serializing writes of \a page */
+  std::mutex &GetPageLock(size_t page) {
+    return page_locks_[page % kPageLocks];
+  }
+
+  /** Get the index entry of \a page */
+  CompressedPage GetEntry(size_t page) {
+    std::lock_guard<std::mutex> lock(index_lock_);
+    return page < index_.size() ? index_[page] : CompressedPage();
+  }
+
+  /** Set the index entry of \a page, in memory and in the index file */
+  bool SetEntry(size_t page, const CompressedPage &entry) {
+    std::lock_guard<std::mutex> lock(index_lock_);
+    if (index_.size() <= page) {
+      index_.resize(page + 1);
+    }
+    index_[page] = entry;
+    off_t off = sizeof(CompressIndexHeader) + page * sizeof(CompressedPage);
+    return HERMES_POSIX_API->pwrite(index_fd_, &entry, sizeof(entry), off) ==
+           sizeof(entry);
+  }
+
+  /** Compress \a size bytes of \a src. Returns 0 if they do not shrink. */
+  size_t Compress(const char *src, size_t size, std::vector<char> &dst) {
+    if (codec_ == Codec::kZstd) {
+      dst.resize(ZSTD_compressBound(size));
+      size_t ret = ZSTD_compress(dst.data(), dst.size(), src, size, level_);
+      return ZSTD_isError(ret) || ret >= size ? 0 : ret;
+    }
+    dst.resize(LZ4_compressBound((int)size));
+    int ret = LZ4_compress_default(src, dst.data(), (int)size,
+                                   (int)dst.size());
+    return ret <= 0 || (size_t)ret >= size ? 0 : (size_t)ret;
+  }
+
+  /** Decompress \a csize bytes of \a src into the \a size bytes of \a dst */
+  bool Decompress(const char *src, size_t csize, char *dst, size_t size) {
+    if (codec_ == Codec::kZstd) {
+      size_t ret = ZSTD_decompress(dst, size, src, csize);
+      return !ZSTD_isError(ret) && ret == size;
+    }
+    int ret = LZ4_decompress_safe(src, dst, (int)csize, (int)size);
+    return ret == (int)size;
+  }
+
+  /** Read page \a page into \a raw. Pages never staged out are empty. */
+  bool ReadPage(size_t page, std::vector<char> &raw) {
+    CompressedPage entry = GetEntry(page);
+    raw.resize(entry.size_);
+    if (entry.size_ == 0) {
+      return true;
+    }
+    int fd = GetFd();
+    if (entry.csize_ == entry.size_) {
+      return HERMES_POSIX_API->pread(fd, raw.data(), entry.size_,
+                                     entry.off_) == (ssize_t)entry.size_;
+    }
+    std::vector<char> comp(entry.csize_);
+    if (HERMES_POSIX_API->pread(fd, comp.data(), entry.csize_, entry.off_) !=
+        (ssize_t)entry.csize_) {
+      return false;
+    }
+    return Decompress(comp.data(), entry.csize_, raw.data(), entry.size_);
+  }
+
+  /** Compress a whole page and append it to the backend file */
+  bool WritePage(size_t page, const char *raw, size_t size) {
+    std::vector<char> comp;
+    CompressedPage entry;
+    entry.size_ = (u32)size;
+    entry.csize_ = (u32)Compress(raw, size, comp);
+    const char *data = comp.data();
+    if (entry.csize_ == 0) {
+      entry.csize_ = entry.size_;
+      data = raw;
+    }
+    {
+      std::lock_guard<std::mutex> lock(index_lock_);
+      entry.off_ = tail_;
+      tail_ += entry.csize_;
+    }
+    if (HERMES_POSIX_API->pwrite(GetFd(), data, entry.csize_, entry.off_) !=
+        (ssize_t)entry.csize_) {
+      return false;
+    }
+    return SetEntry(page, entry);
+  }
+
+  /**
+   * Write \a size bytes at \a off of a page, merging with the stored page.
+   * Whole-page writes take the page lock too, so they cannot land between
+   * the read and the write of a concurrent merge and be overwritten.
+   * */
+  bool WritePart(size_t page, size_t off, const char *data, size_t size) {
+    std::lock_guard<std::mutex> lock(GetPageLock(page));
+    if (off == 0 && size == page_size_) {
+      return WritePage(page, data, size);
+    }
+    std::vector<char> raw;
+    if (!ReadPage(page, raw)) {
+      return false;
+    }
+    if (raw.size() < off + size) {
+      raw.resize(off + size, 0);
+    }
+    memcpy(raw.data() + off, data, size);
+    return WritePage(page, raw.data(), raw.size());
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_COMPRESS_STAGER_H_
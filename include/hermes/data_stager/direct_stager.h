@@ -0,0 +1,312 @@
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_DIRECT_STAGER_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_DIRECT_STAGER_H_
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "binary_stager.h"
+
+namespace hermes {
+
+/**
+ * A file stager that bypasses the page cache with O_DIRECT, so staged
+ * data is not buffered again by the kernel. Aligned I/Os go straight to
+ * the device. Others go through a bounded pool of aligned bounce buffers,
+ * reading back the partially covered head and tail blocks of writes.
+ * Writes which extend the file are serialized, since an unaligned write
+ * past the end trims the padding of its last block afterwards.
+ * */
+class DirectFileStager : public BinaryFileStager {
+ public:
+  CLS_CONST size_t kDefaultAlign = 4096;
+  CLS_CONST u32 kDefaultPoolBufs = 8;
+
+ private:
+  size_t align_ = kDefaultAlign;
+  u32 pool_bufs_ = kDefaultPoolBufs;
+  size_t buf_size_ = 0;      /**< Bytes per bounce buffer */
+  int dfd_ = -1;             /**< The O_DIRECT fd */
+  bool direct_ok_ = true;    /**< False if the file system rejects O_DIRECT */
+  std::vector<char *> pool_; /**< Free bounce buffers */
+  std::mutex pool_lock_;
+  std::mutex rmw_lock_; /**< Serializes partial and extending writes */
+
+ public:
+  /** Default constructor */
+  DirectFileStager() = default;
+
+  /** Destructor */
+  ~DirectFileStager() {
+    if (dfd_ >= 0) {
+      HERMES_POSIX_API->close(dfd_);
+    }
+    for (char *buf : pool_) {
+      free(buf);
+    }
+  }
+
+  /** Build context for staging */
+  static Context BuildContext(size_t page_size, u32 flags = 0,
+                              size_t elmt_size = 1,
+                              size_t align = kDefaultAlign,
+                              u32 pool_bufs = kDefaultPoolBufs) {
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    ctx.bkt_params_ =
+        BuildFileParams(page_size, flags, elmt_size, align, pool_bufs);
+    return ctx;
+  }
+
+  /** Build serialized file parameter pack */
+  static std::string BuildFileParams(size_t page_size, u32 flags = 0,
+                                     size_t elmt_size = 1,
+                                     size_t align = kDefaultAlign,
+                                     u32 pool_bufs = kDefaultPoolBufs) {
+    chi::string params(32);
+    page_size = (page_size / elmt_size) * elmt_size;
+    hipc::LocalSerialize srl(params);
+    srl << std::string("file_direct");
+    srl << flags;
+    srl << page_size;
+    srl << align;
+    srl << pool_bufs;
+    return params.str();
+  }
+
+  /** Create the data stager payload */
+  void RegisterStager(const hipc::MemContext &mctx, const std::string &tag_name,
+                      const std::string &params) override {
+    std::string protocol;
+    hipc::LocalDeserialize srl(params);
+    srl >> protocol;
+    srl >> flags_.bits_;
+    srl >> page_size_;
+    srl >> align_;
+    srl >> pool_bufs_;
+    path_ = tag_name;
+    if (align_ == 0 || (align_ & (align_ - 1)) != 0) {
+      HELOG(kWarning, "Alignment {} of {} is not a power of two, using {}",
+            align_, path_, kDefaultAlign);
+      align_ = kDefaultAlign;
+    }
+    buf_size_ = AlignUp(std::max(page_size_, align_));
+  }
+
+  /** Read \a io from the backend file, bypassing the page cache */
+  bool ReadIo(StageIo &io) override {
+    int fd = GetDirectFd();
+    if (flags_.Any(HERMES_STAGE_NO_READ) || fd < 0) {
+      return BinaryFileStager::ReadIo(io);
+    }
+    FullPtr<char> data(io.data_);
+    size_t off = (size_t)GetFileOff(io);
+    if (IsAligned(data.ptr_, off, io.size_)) {
+      io.result_ = HERMES_POSIX_API->pread(fd, data.ptr_, io.size_, off);
+    } else {
+      io.result_ = DirectRead(fd, data.ptr_, off, io.size_);
+    }
+    return true;
+  }
+
+  /** Write \a io to the backend file, bypassing the page cache */
+  void WriteIo(const hipc::MemContext &mctx, hermes::Client &client,
+               const TagId &tag_id, StageIo &io) override {
+    int fd = GetDirectFd();
+    if (flags_.Any(HERMES_STAGE_NO_WRITE) || fd < 0) {
+      BinaryFileStager::WriteIo(mctx, client, tag_id, io);
+      return;
+    }
+    FullPtr<char> data(io.data_);
+    size_t off = (size_t)GetFileOff(io);
+    if (IsAligned(data.ptr_, off, io.size_)) {
+      io.result_ = AlignedWrite(fd, data.ptr_, off, io.size_);
+    } else {
+      io.result_ = DirectWrite(fd, data.ptr_, off, io.size_);
+    }
+    if (io.result_ < 0) {
+      HELOG(kError, "Failed to stage out {} bytes to {}", io.size_, path_);
+    }
+  }
+
+ private:
+  /**
+   * Open the O_DIRECT fd on first use. File systems without O_DIRECT
+   * support (e.g., tmpfs) fall back to the page-cached fd.
+   * */
+  int GetDirectFd() {
+    std::lock_guard<std::mutex> lock(fd_lock_);
+    if (dfd_ < 0 && direct_ok_) {
+      dfd_ = HERMES_POSIX_API->open(path_.c_str(),
+                                    O_CREAT | O_RDWR | O_DIRECT, 0666);
+      if (dfd_ < 0) {
+        HELOG(kWarning, "O_DIRECT unavailable for {}, using the page cache",
+              path_);
+        direct_ok_ = false;
+      }
+    }
+    return dfd_;
+  }
+
+  /** Round \a off down to the alignment */
+  size_t AlignDown(size_t off) { return off & ~(align_ - 1); }
+
+  /** Round \a off up to the alignment */
+  size_t AlignUp(size_t off) { return AlignDown(off + align_ - 1); }
+
+  /** Whether an I/O can be issued without a bounce buffer */
+  bool IsAligned(const char *ptr, size_t off, size_t size) {
+    return (((uintptr_t)ptr | off | size) & (align_ - 1)) == 0;
+  }
+
+  /** Take a bounce buffer from the pool, or allocate one */
+  char *AcquireBuffer() {
+    {
+      std::lock_guard<std::mutex> lock(pool_lock_);
+      if (!pool_.empty()) {
+        char *buf = pool_.back();
+        pool_.pop_back();
+        return buf;
+      }
+    }
+    void *buf = nullptr;
+    if (posix_memalign(&buf, align_, buf_size_) != 0) {
+      HELOG(kError, "Failed to allocate a {} byte bounce buffer", buf_size_);
+      return nullptr;
+    }
+    return (char *)buf;
+  }
+
+  /** Return a bounce buffer. Buffers beyond the pool size are freed. */
+  void ReleaseBuffer(char *buf) {
+    std::lock_guard<std::mutex> lock(pool_lock_);
+    if (pool_.size() < pool_bufs_) {
+      pool_.emplace_back(buf);
+    } else {
+      free(buf);
+    }
+  }
+
+  /** Read the block at \a off into \a buf, zeroing bytes past EOF */
+  ssize_t ReadBlock(int fd, char *buf, size_t off) {
+    ssize_t ret = HERMES_POSIX_API->pread(fd, buf, align_, off);
+    if (ret < 0) {
+      return ret;
+    }
+    memset(buf + ret, 0, align_ - ret);
+    return ret;
+  }
+
+  /** Read [off, off + size) through bounce buffers */
+  ssize_t DirectRead(int fd, char *data, size_t off, size_t size) {
+    char *bounce = AcquireBuffer();
+    if (bounce == nullptr) {
+      return -1;
+    }
+    size_t end = AlignUp(off + size);
+    ssize_t done = 0;
+    while ((size_t)done < size) {
+      size_t pos = off + done;
+      size_t start = AlignDown(pos);
+      size_t len = std::min(buf_size_, end - start);
+      ssize_t ret = HERMES_POSIX_API->pread(fd, bounce, len, start);
+      if (ret < 0) {
+        done = done > 0 ? done : ret;
+        break;
+      }
+      size_t skip = pos - start;
+      if ((size_t)ret <= skip) {
+        break;
+      }
+      size_t count = std::min((size_t)ret - skip, size - done);
+      memcpy(data + done, bounce + skip, count);
+      done += count;
+      if ((size_t)ret < len) {
+        break;
+      }
+    }
+    ReleaseBuffer(bounce);
+    return done;
+  }
+
+  /**
+   * Write an aligned extent straight from \a data. Writes inside the file
+   * run concurrently. A write past the end takes the write lock, so that
+   * DirectWrite cannot trim the file back over it.
+   * */
+  ssize_t AlignedWrite(int fd, const char *data, size_t off, size_t size) {
+    struct stat st;
+    if (HERMES_POSIX_API->fstat(fd, &st) == 0 &&
+        off + size <= (size_t)st.st_size) {
+      return HERMES_POSIX_API->pwrite(fd, data, size, off);
+    }
+    std::lock_guard<std::mutex> lock(rmw_lock_);
+    return HERMES_POSIX_API->pwrite(fd, data, size, off);
+  }
+
+  /** Write [off, off + size) through bounce buffers */
+  ssize_t DirectWrite(int fd, const char *data, size_t off, size_t size) {
+    char *bounce = AcquireBuffer();
+    if (bounce == nullptr) {
+      return -1;
+    }
+    std::lock_guard<std::mutex> lock(rmw_lock_);
+    struct stat st;
+    if (HERMES_POSIX_API->fstat(fd, &st) < 0) {
+      ReleaseBuffer(bounce);
+      return -1;
+    }
+    size_t file_size = (size_t)st.st_size;
+    size_t end = AlignUp(off + size);
+    ssize_t done = 0;
+    while ((size_t)done < size) {
+      size_t pos = off + done;
+      size_t start = AlignDown(pos);
+      size_t len = std::min(buf_size_, end - start);
+      size_t skip = pos - start;
+      size_t count = std::min(len - skip, size - done);
+      // Keep the bytes of partially written blocks
+      ssize_t ret = 0;
+      if (skip > 0) {
+        ret = ReadBlock(fd, bounce, start);
+      }
+      if (ret >= 0 && skip + count < len &&
+          (skip == 0 || len > align_)) {
+        ret = ReadBlock(fd, bounce + len - align_, start + len - align_);
+      }
+      if (ret >= 0) {
+        memcpy(bounce + skip, data + done, count);
+        ret = HERMES_POSIX_API->pwrite(fd, bounce, len, start);
+      }
+      if (ret < 0) {
+        done = done > 0 ? done : ret;
+        break;
+      }
+      if ((size_t)ret < skip + count) {
+        // A short write stored only the data bytes before ret
+        done += (size_t)ret > skip ? (size_t)ret - skip : 0;
+        break;
+      }
+      done += count;
+    }
+    // Drop the zero padding the last block added past the end of the file
+    if (done > 0 && off + done < end && file_size < end &&
+        HERMES_POSIX_API->fstat(fd, &st) == 0 && (size_t)st.st_size == end) {
+      size_t new_size = std::max(file_size, off + done);
+      if (HERMES_POSIX_API->ftruncate(fd, (off_t)new_size) < 0) {
+        HELOG(kError, "Failed to truncate {} to {} bytes", path_, new_size);
+      }
+    }
+    ReleaseBuffer(bounce);
+    return done;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_DIRECT_STAGER_H_
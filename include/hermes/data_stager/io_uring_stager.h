@@ -0,0 +1,243 @@
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_IO_URING_STAGER_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_IO_URING_STAGER_H_
+
+#include <liburing.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "binary_stager.h"
+
+namespace hermes {
+
+/**
+ * A file stager that queues its reads and writes on an io_uring. Batches
+ * are submitted with one syscall and completions are reaped without
+ * blocking, so the runtime worker can keep many I/Os in flight and run
+ * other tasks meanwhile. Batches drawn from one buffer (such as a flush
+ * buffer) are issued against a registered buffer.
+ *
+ * Each stager owns a ring, which costs an fd and locked memory. At most
+ * kMaxRings rings exist per process. Buckets registered past the limit
+ * use pread/pwrite.
+ * */
+class IoUringStager : public BinaryFileStager {
+ public:
+  CLS_CONST u32 kDefaultDepth = 128;
+  CLS_CONST u32 kMaxRings = 64;
+
+ private:
+  struct io_uring ring_;
+  bool ring_ok_ = false;
+  bool fixed_ok_ = false;
+  u32 depth_ = kDefaultDepth;
+  u32 inflight_ = 0;
+  iovec fixed_ = {nullptr, 0}; /**< The registered buffer (slot 0) */
+  u32 fixed_inflight_ = 0;     /**< I/Os using the registered buffer */
+  std::mutex ring_lock_;       /**< Guards the ring across workers */
+
+ public:
+  /** Default constructor */
+  IoUringStager() = default;
+
+  /** Destructor */
+  ~IoUringStager() {
+    if (ring_ok_) {
+      io_uring_queue_exit(&ring_);
+      GetRingCount().fetch_sub(1);
+    }
+  }
+
+  /** Build context for staging */
+  static Context BuildContext(size_t page_size, u32 flags = 0,
+                              size_t elmt_size = 1,
+                              u32 depth = kDefaultDepth) {
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    ctx.bkt_params_ = BuildFileParams(page_size, flags, elmt_size, depth);
+    return ctx;
+  }
+
+  /** Build serialized file parameter pack */
+  static std::string BuildFileParams(size_t page_size, u32 flags = 0,
+                                     size_t elmt_size = 1,
+                                     u32 depth = kDefaultDepth) {
+    chi::string params(32);
+    page_size = (page_size / elmt_size) * elmt_size;
+    hipc::LocalSerialize srl(params);
+    srl << std::string("io_uring");
+    srl << flags;
+    srl << page_size;
+    srl << depth;
+    return params.str();
+  }
+
+  /** Parse the parameters and set up the ring */
+  void RegisterStager(const hipc::MemContext &mctx, const std::string &tag_name,
+                      const std::string &params) override {
+    std::string protocol;
+    hipc::LocalDeserialize srl(params);
+    srl >> protocol;
+    srl >> flags_.bits_;
+    srl >> page_size_;
+    srl >> depth_;
+    path_ = tag_name;
+    if (GetRingCount().fetch_add(1) >= kMaxRings) {
+      GetRingCount().fetch_sub(1);
+      HELOG(kWarning, "{} io_uring stagers exist, using pread/pwrite for {}",
+            kMaxRings, path_);
+      return;
+    }
+    int ret = io_uring_queue_init(depth_, &ring_, 0);
+    if (ret < 0) {
+      GetRingCount().fetch_sub(1);
+      HELOG(kWarning, "io_uring unavailable for {} ({}), using pread/pwrite",
+            path_, ret);
+      return;
+    }
+    ring_ok_ = true;
+    // Kernels without sparse buffer tables still get plain I/O
+    fixed_ok_ = io_uring_register_buffers_sparse(&ring_, 1) == 0;
+  }
+
+  /**
+   * Queue a batch of reads or writes. I/Os in a direction disabled by the
+   * bucket flags complete at once, as in the file stager.
+   * */
+  void Submit(const hipc::MemContext &mctx, hermes::Client &client,
+              const TagId &tag_id, std::vector<StageIo> &ios) override {
+    int fd = GetFd();
+    if (!ring_ok_ || fd < 0) {
+      BinaryFileStager::Submit(mctx, client, tag_id, ios);
+      return;
+    }
+    for (StageIo &io : ios) {
+      if (io.is_read_ && flags_.Any(HERMES_STAGE_NO_READ)) {
+        ReadIo(io);
+      } else if (!io.is_read_ && flags_.Any(HERMES_STAGE_NO_WRITE)) {
+        WriteIo(mctx, client, tag_id, io);
+      } else {
+        continue;
+      }
+      io.submitted_ = true;
+      io.done_ = true;
+    }
+    std::lock_guard<std::mutex> lock(ring_lock_);
+    RegisterSpan(ios);
+    QueueIos(fd, ios);
+  }
+
+  /** Reap finished I/Os of any batch, queueing the rest of \a ios */
+  bool Reap(std::vector<StageIo> &ios) override {
+    if (!ring_ok_) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(ring_lock_);
+    QueueIos(GetFd(), ios);
+    struct io_uring_cqe *cqe;
+    while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+      uintptr_t data = (uintptr_t)io_uring_cqe_get_data(cqe);
+      StageIo *io = (StageIo *)(data & ~(uintptr_t)1);
+      if (data & 1) {
+        --fixed_inflight_;
+      }
+      io->result_ = cqe->res;
+      io->done_ = true;
+      --inflight_;
+      io_uring_cqe_seen(&ring_, cqe);
+    }
+    for (StageIo &io : ios) {
+      if (!io.done_) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  /**
+   * Register the buffer spanned by a batch as fixed buffer 0, so the
+   * kernel does not pin its pages for every I/O. Single I/Os are not
+   * worth the registration.
+   * */
+  void RegisterSpan(std::vector<StageIo> &ios) {
+    if (!fixed_ok_ || ios.size() < 2 || fixed_inflight_ > 0) {
+      return;
+    }
+    char *begin = nullptr, *end = nullptr;
+    for (StageIo &io : ios) {
+      FullPtr<char> data(io.data_);
+      if (begin == nullptr || data.ptr_ < begin) {
+        begin = data.ptr_;
+      }
+      if (data.ptr_ + io.size_ > end) {
+        end = data.ptr_ + io.size_;
+      }
+    }
+    if (begin == fixed_.iov_base && (size_t)(end - begin) <= fixed_.iov_len) {
+      return;
+    }
+    iovec span = {begin, (size_t)(end - begin)};
+    __u64 tag = 0;
+    if (io_uring_register_buffers_update_tag(&ring_, 0, &span, &tag, 1) < 0) {
+      fixed_ = {nullptr, 0};
+      return;
+    }
+    fixed_ = span;
+  }
+
+  /** The number of stagers holding a ring in this process */
+  static std::atomic<u32> &GetRingCount() {
+    static std::atomic<u32> count(0);
+    return count;
+  }
+
+  /** Whether \a io lies in the registered buffer */
+  bool IsFixed(char *ptr, size_t size) {
+    char *base = (char *)fixed_.iov_base;
+    return base != nullptr && ptr >= base &&
+           ptr + size <= base + fixed_.iov_len;
+  }
+
+  /** Queue the I/Os of \a ios not yet queued, while the ring has room */
+  void QueueIos(int fd, std::vector<StageIo> &ios) {
+    u32 queued = 0;
+    for (StageIo &io : ios) {
+      if (io.submitted_) {
+        continue;
+      }
+      if (inflight_ >= depth_) {
+        break;
+      }
+      struct io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+      if (sqe == nullptr) {
+        break;
+      }
+      FullPtr<char> data(io.data_);
+      off_t off = GetFileOff(io);
+      bool fixed = IsFixed(data.ptr_, io.size_);
+      if (io.is_read_ && fixed) {
+        io_uring_prep_read_fixed(sqe, fd, data.ptr_, io.size_, off, 0);
+      } else if (io.is_read_) {
+        io_uring_prep_read(sqe, fd, data.ptr_, io.size_, off);
+      } else if (fixed) {
+        io_uring_prep_write_fixed(sqe, fd, data.ptr_, io.size_, off, 0);
+      } else {
+        io_uring_prep_write(sqe, fd, data.ptr_, io.size_, off);
+      }
+      io_uring_sqe_set_data(sqe, (void *)((uintptr_t)&io | (fixed ? 1 : 0)));
+      fixed_inflight_ += fixed;
+      io.submitted_ = true;
+      ++inflight_;
+      ++queued;
+    }
+    if (queued > 0) {
+      io_uring_submit(&ring_);
+    }
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_IO_URING_STAGER_H_
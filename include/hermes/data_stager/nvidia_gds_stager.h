@@ -77,24 +77,27 @@ class NvidiaGdsStager : public AbstractStager {
   /** Stage data in from a remote source */
   void StageIn(const hipc::MemContext &mctx, hermes::Client &client,
                const TagId &tag_id, const std::string &blob_name,
-               float score) override {
-    if (flags_.Any(HERMES_STAGE_NO_READ)) {
+               size_t blob_off, size_t data_size, float score) override {
+    if (flags_.Any(HERMES_STAGE_NO_READ) || blob_off >= page_size_) {
       return;
     }
+    if (data_size == 0 || blob_off + data_size > page_size_) {
+      data_size = page_size_ - blob_off;
+    }
 
     adapter::BlobPlacement plcmnt;
     plcmnt.DecodeBlobName(blob_name, page_size_);
 
     void *gpu_ptr = nullptr;
-    cudaError_t err = cudaMalloc(&gpu_ptr, page_size_);
+    cudaError_t err = cudaMalloc(&gpu_ptr, data_size);
     if (err != cudaSuccess) {
       HELOG(kError, "Failed to allocate GPU memory: {}",
             cudaGetErrorString(err));
       return;
     }
 
-    ssize_t real_size =
-        cuFileRead(cufile_handle_, gpu_ptr, page_size_, plcmnt.bucket_off_, 0);
+    ssize_t real_size = cuFileRead(cufile_handle_, gpu_ptr, data_size,
+                                   plcmnt.bucket_off_ + blob_off, 0);
     if (real_size < 0) {
       HELOG(kError, "Failed to read data using cuFile from: {}", path_);
       cudaFree(gpu_ptr);
@@ -105,7 +108,8 @@ class NvidiaGdsStager : public AbstractStager {
   /** Stage data out to a remote source */
   void StageOut(const hipc::MemContext &mctx, hermes::Client &client,
                 const TagId &tag_id, const std::string &blob_name,
-                hipc::Pointer &data_p, size_t data_size) override {
+                size_t blob_off, hipc::Pointer &data_p,
+                size_t data_size) override {
     if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
       return;
     }
@@ -121,8 +125,8 @@ class NvidiaGdsStager : public AbstractStager {
       return;
     }
 
-    ssize_t real_size =
-        cuFileWrite(cufile_handle_, gpu_ptr, data_size, plcmnt.bucket_off_, 0);
+    ssize_t real_size = cuFileWrite(cufile_handle_, gpu_ptr, data_size,
+                                    plcmnt.bucket_off_ + blob_off, 0);
     cudaFree(gpu_ptr);
     if (real_size < 0) {
       HELOG(kError, "Failed to write data using cuFile to: {}", path_);
@@ -130,6 +134,9 @@ class NvidiaGdsStager : public AbstractStager {
     }
   }
 
+  /** The backend bytes covered by each page */
+  size_t GetPageSize() override { return page_size_; }
+
   /** Update metadata size */
   void UpdateSize(const hipc::MemContext &mctx, hermes::Client &client,
                   const TagId &tag_id, const std::string &blob_name,
@@ -139,6 +146,17 @@ class NvidiaGdsStager : public AbstractStager {
     HILOG(kDebug, "Updated size for blob {} with offset {} and size {}",
           blob_name, blob_off, data_size);
   }
+
+  /** Truncate the backend file */
+  void Truncate(const hipc::MemContext &mctx, hermes::Client &client,
+                const TagId &tag_id, size_t new_size) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
+      return;
+    }
+    if (truncate(path_.c_str(), (off_t)new_size) < 0) {
+      HELOG(kError, "Failed to truncate {} to {} bytes", path_, new_size);
+    }
+  }
 };
 
 }  // namespace hermes
@@ -4,11 +4,20 @@
 
 #include "abstract_stager.h"
 #include "binary_stager.h"
+#include "direct_stager.h"
 
 #ifdef HERMES_ENABLE_NVIDIA_GDS_ADAPTER
 #include "nvidia_gds_stager.h"
 #endif
 
+#ifdef HERMES_ENABLE_IO_URING
+#include "io_uring_stager.h"
+#endif
+
+#ifdef HERMES_ENABLE_COMPRESSION
+#include "compress_stager.h"
+#endif
+
 namespace hermes {
 
 class StagerFactory {
@@ -22,6 +31,8 @@ class StagerFactory {
     std::unique_ptr<AbstractStager> stager;
     if (protocol == "file" || protocol == "") {
       stager = std::make_unique<BinaryFileStager>();
+    } else if (protocol == "file_direct") {
+      stager = std::make_unique<DirectFileStager>();
     } else if (protocol == "parquet") {
     } else if (protocol == "hdf5") {
     }
@@ -29,6 +40,16 @@ class StagerFactory {
     else if (protocol == "nvidia_gds") {
       stager = std::make_unique<NvidiaGdsStager>();
     }
+#endif
+#ifdef HERMES_ENABLE_IO_URING
+    else if (protocol == "io_uring") {
+      stager = std::make_unique<IoUringStager>();
+    }
+#endif
+#ifdef HERMES_ENABLE_COMPRESSION
+    else if (protocol == "file+lz4" || protocol == "file+zstd") {
+      stager = std::make_unique<CompressStager>();
+    }
 #endif
     else {
       throw std::runtime_error("Unknown stager type");
@@ -13,8 +13,12 @@
 #ifndef HRUN_TASKS_HERMES_INCLUDE_HERMES_HERMES_TYPES_H_
 #define HRUN_TASKS_HERMES_INCLUDE_HERMES_HERMES_TYPES_H_
 
+#include <algorithm>
+#include <cstring>
+
 #include "bdev/bdev_client.h"
 #include "chimaera/chimaera_types.h"
+#include "interval_set.h"
 #include "status.h"
 #include "statuses.h"
 
@@ -50,8 +54,60 @@ struct TargetInfo {
   FullPtr<chi::bdev::PollStatsTask> poll_stats_;
   chi::BdevStats *stats_;
   float score_ = 0; // TODO(llogan): Calculate score
+  float borg_min_thresh_ = 0; /**< Usage below which the BORG back-fills */
+  float borg_max_thresh_ = 1; /**< Usage above which the BORG demotes */
+  size_t cached_ = 0;      /**< Bytes reserved by lane caches, not in blobs */
+  size_t drain_epoch_ = 0; /**< Bumped to ask lanes to drain their caches */
+
+  size_t GetRemCap() {
+    return __atomic_load_n(&stats_->free_, __ATOMIC_RELAXED);
+  }
+
+  /** Bytes reserved from the target but idle in lane caches */
+  size_t GetCached() { return __atomic_load_n(&cached_, __ATOMIC_RELAXED); }
+
+  /**
+   * Fraction of the target's capacity assigned to blobs after \a size
+   * more bytes. Blocks idle in lane caches do not count as used.
+   * */
+  float GetUsage(size_t size = 0) {
+    float max_cap = (float)stats_->max_cap_;
+    if (max_cap <= 0) {
+      return 1;
+    }
+    float used = max_cap - (float)GetRemCap() - (float)GetCached();
+    return (std::max(used, 0.0f) + (float)size) / max_cap;
+  }
+
+  /** Whether \a size more bytes fit below the max threshold */
+  bool HasRoom(size_t size) {
+    return GetRemCap() >= size && GetUsage(size) <= borg_max_thresh_;
+  }
+
+  /** Atomically account for \a size bytes reserved from the target */
+  void ConsumeCap(size_t size) {
+    __atomic_fetch_sub(&stats_->free_, size, __ATOMIC_RELAXED);
+  }
+
+  /** Atomically account for \a size bytes returned to the target */
+  void ReleaseCap(size_t size) {
+    __atomic_fetch_add(&stats_->free_, size, __ATOMIC_RELAXED);
+  }
+
+  /** Account for a lane cache growing by \a diff bytes (may be negative) */
+  void UpdateCached(ssize_t diff) {
+    __atomic_fetch_add(&cached_, (size_t)diff, __ATOMIC_RELAXED);
+  }
 
-  size_t GetRemCap() { return stats_->free_; }
+  /** Ask every lane to return its idle blocks of the target */
+  void RequestDrain() {
+    __atomic_fetch_add(&drain_epoch_, 1, __ATOMIC_RELAXED);
+  }
+
+  /** The number of drain requests so far */
+  size_t GetDrainEpoch() {
+    return __atomic_load_n(&drain_epoch_, __ATOMIC_RELAXED);
+  }
 };
 
 /** Basic target statistics summary */
@@ -394,12 +450,106 @@ struct BufferInfo : public chi::Block {
       : tid_(tid), chi::Block(block) {}
 };
 
+/** A strong 64-bit fingerprint of a byte string (MurmurHash64A) */
+static inline u64 HashNameFingerprint(const char *data, size_t size,
+                                      u64 seed = 0x9E3779B97F4A7C15ull) {
+  const u64 m = 0xc6a4a7935bd1e995ull;
+  const int r = 47;
+  u64 h = seed ^ (size * m);
+  size_t nblocks = size / sizeof(u64);
+  for (size_t i = 0; i < nblocks; ++i) {
+    u64 k;
+    memcpy(&k, data + i * sizeof(u64), sizeof(u64));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  const unsigned char *tail =
+      reinterpret_cast<const unsigned char *>(data + nblocks * sizeof(u64));
+  switch (size & 7) {
+  case 7:
+    h ^= u64(tail[6]) << 48;
+    [[fallthrough]];
+  case 6:
+    h ^= u64(tail[5]) << 40;
+    [[fallthrough]];
+  case 5:
+    h ^= u64(tail[4]) << 32;
+    [[fallthrough]];
+  case 4:
+    h ^= u64(tail[3]) << 24;
+    [[fallthrough]];
+  case 3:
+    h ^= u64(tail[2]) << 16;
+    [[fallthrough]];
+  case 2:
+    h ^= u64(tail[1]) << 8;
+    [[fallthrough]];
+  case 1:
+    h ^= u64(tail[0]);
+    h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+/**
+ * A fixed-width key for a blob name within a tag. Tag IDs are unique per
+ * node, so tag_fp_ is exact; name_fp_ is a 64-bit fingerprint and callers
+ * compare full names only when two names of a tag share a fingerprint.
+ * */
+struct BlobNameKey {
+  u64 tag_fp_;  /**< Node and unique ID of the tag */
+  u64 name_fp_; /**< Fingerprint of the blob name */
+
+  /** Default constructor */
+  BlobNameKey() = default;
+
+  /** Construct from a tag and blob name */
+  template <typename StringT>
+  BlobNameKey(const TagId &tag_id, const StringT &blob_name)
+      : tag_fp_(tag_id.unique_ ^ (u64(tag_id.node_id_) << 48)),
+        name_fp_(HashNameFingerprint(blob_name.data(), blob_name.size())) {}
+
+  /** Equality */
+  bool operator==(const BlobNameKey &other) const {
+    return tag_fp_ == other.tag_fp_ && name_fp_ == other.name_fp_;
+  }
+
+  /** Inequality */
+  bool operator!=(const BlobNameKey &other) const { return !(*this == other); }
+};
+
+/** The blob name of a page in a paged bucket (e.g., a file) */
+static inline chi::string GetPageBlobName(size_t page) {
+  chi::string buf(sizeof(page));
+  hipc::LocalSerialize srl(buf);
+  srl << page;
+  return buf;
+}
+
+/** Parse the page index out of a page blob name. False if not one. */
+template <typename StringT>
+static inline bool ParsePageBlobName(const StringT &blob_name, size_t &page) {
+  if (blob_name.size() != sizeof(page)) {
+    return false;
+  }
+  hipc::LocalDeserialize srl(blob_name);
+  srl >> page;
+  return true;
+}
+
 /** Data structure used to store Blob information */
 struct BlobInfo {
   TagId tag_id_;                    /**< Tag the blob is on */
   BlobId blob_id_;                  /**< Unique ID of the blob */
   chi::string name_;                /**< Name of the blob (without tag_id) */
   std::vector<BufferInfo> buffers_; /**< Set of buffers */
+  std::vector<size_t> buffer_offs_; /**< Blob offset of each buffer */
   std::vector<TagId> tags_;         /**< Set of tags */
   size_t blob_size_;                /**< The overall size of the blob */
   size_t max_blob_size_; /**< The amount of space current buffers support */
@@ -411,15 +561,19 @@ struct BlobInfo {
       mod_count_; /**< The number of times blob modified */
   hipc::atomic<hshm::big_uint>
       last_flush_;     /**< The last mod that was flushed */
+  u64 tag_gen_;        /**< Generation of the tag the blob was written in */
   bitfield32_t flags_; /**< Flags */
+  IntervalSet valid_;  /**< Byte ranges written or staged in */
+  IntervalSet dirty_;  /**< Byte ranges written since the last flush */
 #ifdef CHIMAERA_RUNTIME
   chi::CoRwLock lock_; /**< Lock */
 #endif
 
   /** Serialization */
   template <typename Ar> void serialize(Ar &ar) {
-    ar(tag_id_, blob_id_, name_, buffers_, tags_, blob_size_, max_blob_size_,
-       score_, access_freq_, mod_count_, last_flush_);
+    ar(tag_id_, blob_id_, name_, buffers_, buffer_offs_, tags_, blob_size_,
+       max_blob_size_, score_, access_freq_, mod_count_, last_flush_,
+       tag_gen_);
   }
 
   /** Default constructor */
@@ -431,6 +585,7 @@ struct BlobInfo {
     blob_id_ = other.blob_id_;
     name_ = other.name_;
     buffers_ = other.buffers_;
+    buffer_offs_ = other.buffer_offs_;
     tags_ = other.tags_;
     blob_size_ = other.blob_size_;
     max_blob_size_ = other.max_blob_size_;
@@ -440,6 +595,61 @@ struct BlobInfo {
     last_access_ = other.last_access_;
     mod_count_ = other.mod_count_.load();
     last_flush_ = other.last_flush_.load();
+    tag_gen_ = other.tag_gen_;
+    valid_ = other.valid_;
+    dirty_ = other.dirty_;
+  }
+
+  /** Append a buffer to the end of the blob */
+  void AppendBuffer(const TargetId &tid, const chi::Block &block) {
+    buffer_offs_.emplace_back(GetBufferCapacity());
+    buffers_.emplace_back(tid, block);
+  }
+
+  /** Remove all buffers */
+  void ClearBuffers() {
+    buffers_.clear();
+    buffer_offs_.clear();
+  }
+
+  /**
+   * Remove the buffers lying entirely past blob offset \a size.
+   * The removed buffers are appended to \a freed.
+   * */
+  void TruncateBuffers(size_t size, std::vector<BufferInfo> &freed) {
+    size_t keep = size == 0 ? 0 : std::min(FindBuffer(size - 1) + 1,
+                                           buffers_.size());
+    freed.insert(freed.end(), buffers_.begin() + keep, buffers_.end());
+    buffers_.resize(keep);
+    buffer_offs_.resize(keep);
+  }
+
+  /** The number of bytes the buffers can hold */
+  size_t GetBufferCapacity() const {
+    if (buffers_.empty()) {
+      return 0;
+    }
+    return buffer_offs_.back() + buffers_.back().size_;
+  }
+
+  /** The blob offset of buffer \a idx (the capacity if past the end) */
+  size_t GetBufferOff(size_t idx) const {
+    if (idx < buffer_offs_.size()) {
+      return buffer_offs_[idx];
+    }
+    return GetBufferCapacity();
+  }
+
+  /**
+   * Binary search for the buffer holding blob offset \a off.
+   * Returns buffers_.size() if \a off is past the last buffer.
+   * */
+  size_t FindBuffer(size_t off) const {
+    if (off >= GetBufferCapacity()) {
+      return buffers_.size();
+    }
+    auto it = std::upper_bound(buffer_offs_.begin(), buffer_offs_.end(), off);
+    return (it - buffer_offs_.begin()) - 1;
   }
 
   /** Update modify stats */
@@ -454,19 +664,14 @@ struct BlobInfo {
     access_freq_.fetch_add(1);
   }
 
-  /** Get the globally unique blob name */
-  static const chi::string GetBlobNameWithBucket(const TagId &tag_id,
-                                                 const chi::string &blob_name) {
-    chi::string new_name(sizeof(TagId) + blob_name.size());
-    hipc::LocalSerialize srl(new_name);
-    srl << tag_id;
-    srl << blob_name;
-    return new_name;
-  }
+  /** Get the key of this blob in the blob ID map */
+  BlobNameKey GetBlobNameKey() const { return BlobNameKey(tag_id_, name_); }
 
-  /** Return the unique blob name for blob_id_map */
-  chi::string GetBlobNameWithBucket() {
-    return GetBlobNameWithBucket(tag_id_, name_);
+  /** Check if this blob is named blob_name in tag_id */
+  template <typename StringT>
+  bool HasName(const TagId &tag_id, const StringT &blob_name) const {
+    return tag_id_ == tag_id && name_.size() == blob_name.size() &&
+           memcmp(name_.data(), blob_name.data(), name_.size()) == 0;
   }
 
   /** Get std::string of name */
@@ -478,16 +683,19 @@ struct TagInfo {
   TagId tag_id_;
   chi::string name_;
   std::list<BlobId> blobs_;
+  std::list<BlobId> stale_blobs_; /**< Blobs of older generations */
   std::list<Task *> traits_;
   size_t internal_size_;
   size_t page_size_;
+  u64 generation_; /**< Bumped each time the tag is cleared */
   bitfield32_t flags_;
   bool owner_;
   // chi::CoRwLock lock_;
 
   /** Serialization */
   template <typename Ar> void serialize(Ar &ar) {
-    ar(tag_id_, name_, internal_size_, page_size_, owner_, flags_);
+    ar(tag_id_, name_, internal_size_, page_size_, generation_, owner_,
+       flags_);
   }
 
   /** Get std::string of name */
@@ -615,4 +823,13 @@ enum LockOwners {
 
 } // namespace hermes
 
+namespace std {
+/** Hash function for BlobNameKey */
+template <> struct hash<hermes::BlobNameKey> {
+  size_t operator()(const hermes::BlobNameKey &key) const {
+    return key.name_fp_ ^ (key.tag_fp_ * 0x9E3779B97F4A7C15ull);
+  }
+};
+} // namespace std
+
 #endif // HRUN_TASKS_HERMES_INCLUDE_HERMES_HERMES_TYPES_H_
@@ -0,0 +1,152 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_INCLUDE_HERMES_INTERVAL_SET_H_
+#define HERMES_INCLUDE_HERMES_INTERVAL_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace hermes {
+
+/** A byte range [off_, off_ + size_) of a blob */
+struct Extent {
+  size_t off_ = 0;
+  size_t size_ = 0;
+
+  /** One past the last byte of the range */
+  size_t End() const { return off_ + size_; }
+
+  bool operator==(const Extent &other) const {
+    return off_ == other.off_ && size_ == other.size_;
+  }
+};
+
+/**
+ * A set of disjoint byte ranges. Overlapping and adjacent ranges are
+ * merged on insertion, so a blob written in many small pieces stays a
+ * handful of extents.
+ * */
+class IntervalSet {
+ private:
+  std::map<size_t, size_t> ranges_; /**< Start of each range to its end */
+
+ public:
+  /** Number of disjoint ranges */
+  size_t size() const { return ranges_.size(); }
+
+  /** Whether the set holds no bytes */
+  bool empty() const { return ranges_.empty(); }
+
+  /** Remove all ranges */
+  void Clear() { ranges_.clear(); }
+
+  /** Exchange the ranges of two sets */
+  void swap(IntervalSet &other) { ranges_.swap(other.ranges_); }
+
+  /** Add the range [off, off + size) */
+  void Insert(size_t off, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    size_t end = off + size;
+    auto it = ranges_.upper_bound(off);
+    if (it != ranges_.begin() && std::prev(it)->second >= off) {
+      --it;
+      off = it->first;
+    }
+    while (it != ranges_.end() && it->first <= end) {
+      end = std::max(end, it->second);
+      it = ranges_.erase(it);
+    }
+    ranges_.emplace(off, end);
+  }
+
+  /** Remove the range [off, off + size) */
+  void Erase(size_t off, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    size_t end = off + size;
+    auto it = ranges_.upper_bound(off);
+    if (it != ranges_.begin() && std::prev(it)->second > off) {
+      --it;
+    }
+    while (it != ranges_.end() && it->first < end) {
+      size_t begin = it->first, last = it->second;
+      it = ranges_.erase(it);
+      if (begin < off) {
+        ranges_.emplace(begin, off);
+      }
+      if (last > end) {
+        ranges_.emplace(end, last);
+      }
+    }
+  }
+
+  /** Remove every byte at or past \a size */
+  void Truncate(size_t size) {
+    Erase(size, std::numeric_limits<size_t>::max() - size);
+  }
+
+  /** Whether every byte of [off, off + size) is in the set */
+  bool Contains(size_t off, size_t size) const {
+    if (size == 0) {
+      return true;
+    }
+    auto it = ranges_.upper_bound(off);
+    if (it == ranges_.begin()) {
+      return false;
+    }
+    --it;
+    return it->second >= off + size;
+  }
+
+  /** Append the parts of [off, off + size) in the set to \a extents */
+  void GetExtents(size_t off, size_t size,
+                  std::vector<Extent> &extents) const {
+    size_t end = off + size;
+    auto it = ranges_.upper_bound(off);
+    if (it != ranges_.begin() && std::prev(it)->second > off) {
+      --it;
+    }
+    for (; it != ranges_.end() && it->first < end; ++it) {
+      size_t begin = std::max(it->first, off);
+      extents.emplace_back(Extent{begin, std::min(it->second, end) - begin});
+    }
+  }
+
+  /** Append the parts of [off, off + size) not in the set to \a gaps */
+  void GetGaps(size_t off, size_t size, std::vector<Extent> &gaps) const {
+    size_t end = off + size;
+    std::vector<Extent> extents;
+    GetExtents(off, size, extents);
+    for (const Extent &extent : extents) {
+      if (extent.off_ > off) {
+        gaps.emplace_back(Extent{off, extent.off_ - off});
+      }
+      off = extent.End();
+    }
+    if (off < end) {
+      gaps.emplace_back(Extent{off, end - off});
+    }
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_INTERVAL_SET_H_
@@ -0,0 +1,406 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_METADATA_INDEX_H_
+#define HERMES_INCLUDE_HERMES_METADATA_INDEX_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "chimaera/chimaera_types.h"
+
+namespace hermes {
+
+/**
+ * An open-addressing (linear probing) hash index with inline keys and values.
+ *
+ * There is a single writer at a time: the owning lane must hold its
+ * CoRwLock for writing to insert, update or erase. Readers may probe
+ * without taking any lock: every slot is guarded by a sequence counter.
+ * Tables replaced by a rehash are retired, and only freed once the writer
+ * sees no reader in flight, so a reader never touches freed memory no
+ * matter how long it is preempted. Lookups never allocate. KeyT and ValT
+ * must be trivially copyable.
+ * */
+template <typename KeyT, typename ValT, typename HashT = std::hash<KeyT>>
+class MetadataIndex {
+ public:
+  CLS_CONST u32 kEmpty = 0;
+  CLS_CONST u32 kFull = 1;
+  CLS_CONST u32 kTombstone = 2;
+  CLS_CONST u32 kBusy = 3;
+  CLS_CONST size_t kMinSlots = 64;
+
+  /** A slot in the table. ctrl_ is (version << 2) | state */
+  struct Slot {
+    std::atomic<u32> ctrl_;
+    KeyT key_;
+    ValT val_;
+
+    Slot() : ctrl_(kEmpty) {}
+  };
+
+  /** A table of slots */
+  struct Table {
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    explicit Table(size_t num_slots)
+        : mask_(num_slots - 1), slots_(new Slot[num_slots]) {}
+    size_t Capacity() const { return mask_ + 1; }
+  };
+
+ private:
+  std::atomic<Table *> table_;
+  std::unique_ptr<Table> owned_;
+  std::vector<std::unique_ptr<Table>> retired_;
+  mutable std::atomic<size_t> readers_; /**< Lock-free probes in flight */
+  size_t count_ = 0;
+  size_t tombstones_ = 0;
+
+ public:
+  /** Constructor. Presize for est_count entries. */
+  explicit MetadataIndex(size_t est_count = 0)
+      : table_(nullptr), readers_(0) {
+    Reserve(est_count);
+  }
+
+  MetadataIndex(const MetadataIndex &) = delete;
+  MetadataIndex &operator=(const MetadataIndex &) = delete;
+
+  /** Move constructor (only valid before concurrent use) */
+  MetadataIndex(MetadataIndex &&other) noexcept
+      : table_(other.table_.load()),
+        owned_(std::move(other.owned_)),
+        retired_(std::move(other.retired_)),
+        readers_(0),
+        count_(other.count_),
+        tombstones_(other.tombstones_) {
+    other.table_ = nullptr;
+    other.count_ = 0;
+    other.tombstones_ = 0;
+  }
+
+  /** Number of entries */
+  size_t size() const { return count_; }
+
+  /** Whether the index is empty */
+  bool empty() const { return count_ == 0; }
+
+  /** Ensure count entries fit without a rehash (writer only) */
+  void Reserve(size_t count) {
+    size_t num_slots = SlotsFor(count);
+    if (owned_ == nullptr || owned_->Capacity() < num_slots) {
+      Rehash(num_slots);
+    }
+  }
+
+  /** Copy the value of key into val. Lock-free. */
+  bool Find(const KeyT &key, ValT &val) const {
+    readers_.fetch_add(1, std::memory_order_seq_cst);
+    bool found = Probe(table_.load(std::memory_order_seq_cst), key, val);
+    readers_.fetch_sub(1, std::memory_order_release);
+    return found;
+  }
+
+  /** Whether key is in the index. Lock-free. */
+  bool Contains(const KeyT &key) const {
+    ValT val;
+    return Find(key, val);
+  }
+
+  /** Number of retired tables not yet freed */
+  size_t GetRetired() const { return retired_.size(); }
+
+  /**
+   * Free the retired tables if no lock-free reader is in flight (writer
+   * only). Readers starting later load the current table, so a moment
+   * with no readers is a quiescent point for every retired table.
+   * */
+  void Reclaim() {
+    if (!retired_.empty() &&
+        readers_.load(std::memory_order_seq_cst) == 0) {
+      retired_.clear();
+    }
+  }
+
+  /** Get a pointer to the value of key (writer or lock holder only) */
+  ValT *Get(const KeyT &key) {
+    if (owned_ == nullptr) {
+      return nullptr;
+    }
+    Slot *slot = FindSlot(*owned_, key);
+    return slot ? &slot->val_ : nullptr;
+  }
+
+  /** Insert key if it does not exist. Returns false if it existed. */
+  bool Emplace(const KeyT &key, const ValT &val) {
+    if (owned_ != nullptr && FindSlot(*owned_, key)) {
+      return false;
+    }
+    if (owned_ == nullptr ||
+        (count_ + tombstones_ + 1) * 10 > owned_->Capacity() * 7) {
+      size_t cur_slots = owned_ ? owned_->Capacity() : 0;
+      Rehash(std::max(cur_slots, SlotsFor(count_ + 1)));
+    }
+    Table &table = *owned_;
+    size_t idx = Mix(HashT{}(key)) & table.mask_;
+    for (size_t i = 0;; ++i) {
+      Slot &slot = table.slots_[(idx + i) & table.mask_];
+      u32 state = slot.ctrl_.load(std::memory_order_relaxed) & 3;
+      if (state == kEmpty || state == kTombstone) {
+        if (state == kTombstone) {
+          --tombstones_;
+        }
+        Publish(slot, key, val, kFull);
+        ++count_;
+        Reclaim();
+        return true;
+      }
+    }
+  }
+
+  /** Replace the value of an existing key */
+  bool Update(const KeyT &key, const ValT &val) {
+    if (owned_ == nullptr) {
+      return false;
+    }
+    Slot *slot = FindSlot(*owned_, key);
+    if (slot == nullptr) {
+      return false;
+    }
+    Publish(*slot, key, val, kFull);
+    return true;
+  }
+
+  /** Remove key. Returns false if it did not exist. */
+  bool Erase(const KeyT &key) {
+    if (owned_ == nullptr) {
+      return false;
+    }
+    Slot *slot = FindSlot(*owned_, key);
+    if (slot == nullptr) {
+      return false;
+    }
+    Publish(*slot, slot->key_, slot->val_, kTombstone);
+    --count_;
+    ++tombstones_;
+    Reclaim();
+    return true;
+  }
+
+  /** Remove all entries (writer only) */
+  void Clear() {
+    if (owned_ != nullptr) {
+      Rehash(owned_->Capacity(), false);
+    }
+  }
+
+  /** Call func(key, val) on each entry (writer or lock holder only) */
+  template <typename FUNC> void ForEach(FUNC &&func) {
+    if (owned_ == nullptr) {
+      return;
+    }
+    Table &table = *owned_;
+    for (size_t i = 0; i < table.Capacity(); ++i) {
+      Slot &slot = table.slots_[i];
+      if ((slot.ctrl_.load(std::memory_order_relaxed) & 3) == kFull) {
+        func(slot.key_, slot.val_);
+      }
+    }
+  }
+
+ private:
+  /** Look up key in \a table */
+  static bool Probe(const Table *table, const KeyT &key, ValT &val) {
+    if (table == nullptr) {
+      return false;
+    }
+    size_t idx = Mix(HashT{}(key)) & table->mask_;
+    for (size_t i = 0; i <= table->mask_; ++i) {
+      const Slot &slot = table->slots_[(idx + i) & table->mask_];
+      while (true) {
+        u32 c1 = slot.ctrl_.load(std::memory_order_acquire);
+        u32 state = c1 & 3;
+        if (state == kEmpty) {
+          return false;
+        }
+        if (state == kBusy) {
+          continue;
+        }
+        KeyT slot_key = slot.key_;
+        ValT slot_val = slot.val_;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.ctrl_.load(std::memory_order_relaxed) != c1) {
+          continue;
+        }
+        if (state == kFull && slot_key == key) {
+          val = slot_val;
+          return true;
+        }
+        break;
+      }
+    }
+    return false;
+  }
+
+  /** Scramble a possibly weak hash */
+  static size_t Mix(size_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  /** Number of slots to hold count entries below a 70% load */
+  static size_t SlotsFor(size_t count) {
+    size_t want = count * 10 / 7 + 1;
+    size_t num_slots = kMinSlots;
+    while (num_slots < want) {
+      num_slots <<= 1;
+    }
+    return num_slots;
+  }
+
+  /** Find the slot holding key (writer only) */
+  Slot *FindSlot(Table &table, const KeyT &key) {
+    size_t idx = Mix(HashT{}(key)) & table.mask_;
+    for (size_t i = 0; i <= table.mask_; ++i) {
+      Slot &slot = table.slots_[(idx + i) & table.mask_];
+      u32 state = slot.ctrl_.load(std::memory_order_relaxed) & 3;
+      if (state == kEmpty) {
+        return nullptr;
+      }
+      if (state == kFull && slot.key_ == key) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  /** Write a slot under its sequence counter */
+  static void Publish(Slot &slot, const KeyT &key, const ValT &val,
+                      u32 state) {
+    u32 version = (slot.ctrl_.load(std::memory_order_relaxed) >> 2) + 1;
+    slot.ctrl_.store((version << 2) | kBusy, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.key_ = key;
+    slot.val_ = val;
+    slot.ctrl_.store(((version + 1) << 2) | state, std::memory_order_release);
+  }
+
+  /** Move all entries into a new table of num_slots */
+  void Rehash(size_t num_slots, bool keep_entries = true) {
+    std::unique_ptr<Table> table = std::make_unique<Table>(num_slots);
+    if (owned_ != nullptr && keep_entries) {
+      for (size_t i = 0; i < owned_->Capacity(); ++i) {
+        Slot &old_slot = owned_->slots_[i];
+        if ((old_slot.ctrl_.load(std::memory_order_relaxed) & 3) != kFull) {
+          continue;
+        }
+        size_t idx = Mix(HashT{}(old_slot.key_)) & table->mask_;
+        while ((table->slots_[idx].ctrl_.load(std::memory_order_relaxed) &
+                3) != kEmpty) {
+          idx = (idx + 1) & table->mask_;
+        }
+        Publish(table->slots_[idx], old_slot.key_, old_slot.val_, kFull);
+      }
+    } else {
+      count_ = 0;
+    }
+    tombstones_ = 0;
+    table_.store(table.get(), std::memory_order_seq_cst);
+    // Keep the previous tables alive for in-flight lock-free readers
+    if (owned_ != nullptr) {
+      retired_.emplace_back(std::move(owned_));
+    }
+    owned_ = std::move(table);
+    Reclaim();
+  }
+};
+
+/**
+ * A table of metadata objects with stable addresses, indexed by a
+ * MetadataIndex. Objects are only created and destroyed by the owning lane.
+ * */
+template <typename KeyT, typename T, typename HashT = std::hash<KeyT>>
+class MetadataTable {
+ public:
+  MetadataIndex<KeyT, T *, HashT> index_;
+
+ public:
+  /** Constructor */
+  explicit MetadataTable(size_t est_count = 0) : index_(est_count) {}
+
+  /** Destructor */
+  ~MetadataTable() { Clear(); }
+
+  MetadataTable(const MetadataTable &) = delete;
+  MetadataTable &operator=(const MetadataTable &) = delete;
+
+  /** Move constructor (only valid before concurrent use) */
+  MetadataTable(MetadataTable &&other) noexcept
+      : index_(std::move(other.index_)) {}
+
+  /** Presize the index */
+  void Reserve(size_t count) { index_.Reserve(count); }
+
+  /** Number of entries */
+  size_t size() const { return index_.size(); }
+
+  /** Find an object. Lock-free; dereference only under the lane lock. */
+  T *Find(const KeyT &key) const {
+    T *obj = nullptr;
+    index_.Find(key, obj);
+    return obj;
+  }
+
+  /** Get an existing object or default-construct a new one */
+  T &Emplace(const KeyT &key, bool &did_create) {
+    T *obj = Find(key);
+    did_create = obj == nullptr;
+    if (did_create) {
+      obj = new T();
+      index_.Emplace(key, obj);
+    }
+    return *obj;
+  }
+
+  /** Destroy an object */
+  bool Erase(const KeyT &key) {
+    T *obj = Find(key);
+    if (obj == nullptr) {
+      return false;
+    }
+    index_.Erase(key);
+    delete obj;
+    return true;
+  }
+
+  /** Destroy all objects */
+  void Clear() {
+    index_.ForEach([](const KeyT &key, T *obj) { delete obj; });
+    index_.Clear();
+  }
+
+  /** Call func(key, obj) for each object */
+  template <typename FUNC> void ForEach(FUNC &&func) {
+    index_.ForEach([&func](const KeyT &key, T *obj) { func(key, *obj); });
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_METADATA_INDEX_H_
@@ -0,0 +1,114 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_READ_AHEAD_H_
+#define HERMES_INCLUDE_HERMES_READ_AHEAD_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/**
+ * Detects sequential or strided page reads of one tag and decides which
+ * pages to stage in ahead of the reader.
+ *
+ * A stream starts once kMinStreak reads in a row advance by the same
+ * stride. The window of pages kept ahead of the reader doubles while
+ * reads hit prefetched pages and halves when a stream ends with most of
+ * its prefetched pages unused.
+ * */
+class ReadAhead {
+ public:
+  CLS_CONST size_t kMinStreak = 2;  /**< Matching strides before prefetch */
+  CLS_CONST size_t kMinWindow = 2;  /**< Smallest window (pages) */
+
+ private:
+  ssize_t last_page_ = -1; /**< Last page read */
+  ssize_t stride_ = 0;     /**< Distance between the last two reads */
+  size_t streak_ = 0;      /**< Reads in a row with the same stride */
+  ssize_t next_page_ = 0;  /**< Next page of the stream to prefetch */
+  size_t window_;          /**< Pages to keep ahead of the reader */
+  size_t max_window_;      /**< Largest window */
+  size_t issued_ = 0;      /**< Pages prefetched in this stream */
+  size_t hits_ = 0;        /**< Reads of prefetched pages in this stream */
+
+ public:
+  /** Default constructor */
+  ReadAhead() : ReadAhead(32) {}
+
+  /** Construct with the largest window */
+  explicit ReadAhead(size_t max_window)
+      : max_window_(std::max(max_window, kMinWindow)) {
+    window_ = std::min(kMinWindow * 2, max_window_);
+  }
+
+  /** Pages currently kept ahead of the reader */
+  size_t GetWindow() const { return window_; }
+
+  /**
+   * Record a read of \a page. \a hit tells whether the page was already
+   * staged in. The pages to stage in next are appended to \a pages.
+   * */
+  void Observe(size_t page, bool hit, std::vector<size_t> &pages) {
+    ssize_t cur = (ssize_t)page;
+    if (last_page_ < 0) {
+      last_page_ = cur;
+      return;
+    }
+    ssize_t stride = cur - last_page_;
+    last_page_ = cur;
+    if (stride != 0 && stride == stride_) {
+      ++streak_;
+    } else {
+      EndStream();
+      stride_ = stride;
+      streak_ = 1;
+      next_page_ = cur + stride;
+      return;
+    }
+    if (streak_ < kMinStreak) {
+      return;
+    }
+    // Grow the window while the reader consumes prefetched pages
+    if (hit && issued_ > 0) {
+      ++hits_;
+      window_ = std::min(window_ * 2, max_window_);
+    }
+    // Keep the window filled ahead of the reader
+    ssize_t end = cur + stride_ * (ssize_t)window_;
+    if ((next_page_ - cur) * stride_ <= 0) {
+      next_page_ = cur + stride_;
+    }
+    for (; (end - next_page_) * stride_ >= 0 && next_page_ >= 0;
+         next_page_ += stride_) {
+      pages.emplace_back((size_t)next_page_);
+      ++issued_;
+    }
+  }
+
+ private:
+  /** Shrink the window if the stream wasted most of its prefetches */
+  void EndStream() {
+    if (issued_ > 0 && hits_ * 2 < issued_) {
+      window_ = std::max(window_ / 2, kMinWindow);
+    }
+    issued_ = 0;
+    hits_ = 0;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_READ_AHEAD_H_
@@ -141,9 +141,9 @@ public:
   CHI_BEGIN(TagClearBlobs)
   /** Clear blobs from a tag */
   void TagClearBlobs(const hipc::MemContext &mctx, const DomainQuery &dom_query,
-                     const TagId &tag_id) {
+                     const TagId &tag_id, u64 generation = 0) {
     FullPtr<TagClearBlobsTask> task =
-        AsyncTagClearBlobs(mctx, dom_query, tag_id);
+        AsyncTagClearBlobs(mctx, dom_query, tag_id, generation);
     task->Wait();
     CHI_CLIENT->DelTask(mctx, task);
   }
@@ -189,6 +189,18 @@ public:
   CHI_TASK_METHODS(TagFlush);
   CHI_END(TagFlush)
 
+  CHI_BEGIN(TagTruncate)
+  /** Truncate the pages of a tag to \a new_size bytes */
+  void TagTruncate(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                   const TagId &tag_id, size_t new_size, size_t page_size) {
+    FullPtr<TagTruncateTask> task =
+        AsyncTagTruncate(mctx, dom_query, tag_id, new_size, page_size);
+    task->Wait();
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(TagTruncate);
+  CHI_END(TagTruncate)
+
   /**====================================
    * Blob Operations
    * ===================================*/
@@ -285,8 +297,10 @@ public:
   CHI_BEGIN(ReorganizeNode)
   /** ReorganizeNode task */
   void ReorganizeNode(const hipc::MemContext &mctx,
-                      const DomainQuery &dom_query) {
-    FullPtr<ReorganizeNodeTask> task = AsyncReorganizeNode(mctx, dom_query);
+                      const DomainQuery &dom_query, size_t period_ms = 1024,
+                      u32 lane_hash = 0) {
+    FullPtr<ReorganizeNodeTask> task =
+        AsyncReorganizeNode(mctx, dom_query, period_ms, lane_hash);
     task->Wait();
     CHI_CLIENT->DelTask(mctx, task);
   }
@@ -360,6 +374,18 @@ public:
   CHI_TASK_METHODS(GetBlobName);
   CHI_END(GetBlobName)
 
+  CHI_BEGIN(PrefetchBlob)
+  /** Stage in the page blob \a blob_id ahead of a reader */
+  void PrefetchBlob(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                    const TagId &tag_id, const BlobId &blob_id, float score) {
+    FullPtr<PrefetchBlobTask> task =
+        AsyncPrefetchBlob(mctx, dom_query, tag_id, blob_id, score);
+    task->Wait();
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(PrefetchBlob);
+  CHI_END(PrefetchBlob)
+
   CHI_BEGIN(GetBlobSize)
   /**
    * Get \a size from \a blob_id BLOB id
@@ -417,9 +443,9 @@ public:
    * */
   void TruncateBlob(const hipc::MemContext &mctx, const DomainQuery &dom_query,
                     const TagId &tag_id, const BlobId &blob_id,
-                    size_t new_size) {
-    FullPtr<TruncateBlobTask> task =
-        AsyncTruncateBlob(mctx, dom_query, tag_id, blob_id, new_size);
+                    size_t new_size, u32 blob_flags = 0) {
+    FullPtr<TruncateBlobTask> task = AsyncTruncateBlob(
+        mctx, dom_query, tag_id, blob_id, new_size, blob_flags);
     task->Wait();
     CHI_CLIENT->DelTask(mctx, task);
   }
@@ -455,14 +481,72 @@ public:
   CHI_BEGIN(FlushData)
   /** FlushData task */
   void FlushData(const hipc::MemContext &mctx, const DomainQuery &dom_query,
-                 int period_sec = 5) {
-    FullPtr<FlushDataTask> task = AsyncFlushData(mctx, dom_query, period_sec);
+                 int period_sec = 5, u32 lane_hash = 0) {
+    FullPtr<FlushDataTask> task =
+        AsyncFlushData(mctx, dom_query, period_sec, lane_hash);
     task->Wait();
     CHI_CLIENT->DelTask(mctx, task);
   }
   CHI_TASK_METHODS(FlushData);
   CHI_END(FlushData)
 
+  CHI_BEGIN(PutBlobBatch)
+  /**
+   * Put data in many blobs of a tag using a single task
+   *
+   * @param tag_id id of the bucket
+   * @param blob_names semantic blob names (may be empty if IDs are known)
+   * @param[INOUT] entries the blobs to put. Blob IDs are filled in.
+   * @param score the score of the blobs
+   * */
+  template <typename StringT>
+  void PutBlobBatch(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                    const TagId &tag_id,
+                    const std::vector<StringT> &blob_names,
+                    std::vector<BlobBatchEntry> &entries, float score,
+                    u32 task_flags, u32 hermes_flags,
+                    const Context &ctx = Context()) {
+    FullPtr<PutBlobBatchTask> task =
+        AsyncPutBlobBatch(mctx, dom_query, tag_id, blob_names, entries, score,
+                          task_flags, hermes_flags, ctx);
+    task->Wait();
+    for (size_t i = 0; i < entries.size(); ++i) {
+      entries[i].blob_id_ = task->entries_[i].blob_id_;
+    }
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(PutBlobBatch);
+  CHI_END(PutBlobBatch)
+
+  CHI_BEGIN(GetBlobBatch)
+  /**
+   * Get data from many blobs of a tag using a single task
+   *
+   * @param tag_id id of the bucket
+   * @param blob_names semantic blob names (may be empty if IDs are known)
+   * @param[INOUT] entries the blobs to get. Blob IDs and sizes are filled in.
+   * @param hermes_flags with HERMES_GET_BLOB_SIZE, no data is read and the
+   * size of each blob is returned in its data_size_
+   * */
+  template <typename StringT>
+  void GetBlobBatch(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                    const TagId &tag_id,
+                    const std::vector<StringT> &blob_names,
+                    std::vector<BlobBatchEntry> &entries, u32 hermes_flags,
+                    const Context &ctx = Context()) {
+    FullPtr<GetBlobBatchTask> task =
+        AsyncGetBlobBatch(mctx, dom_query, tag_id, blob_names, entries, 0, 0,
+                          hermes_flags, ctx);
+    task->Wait();
+    for (size_t i = 0; i < entries.size(); ++i) {
+      entries[i].blob_id_ = task->entries_[i].blob_id_;
+      entries[i].data_size_ = task->entries_[i].data_size_;
+    }
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(GetBlobBatch);
+  CHI_END(GetBlobBatch)
+
   CHI_BEGIN(PollBlobMetadata)
   /** PollBlobMetadata task */
   std::vector<BlobInfo> PollBlobMetadata(const hipc::MemContext &mctx,
@@ -562,9 +646,10 @@ public:
   /** StageIn task */
   void StageIn(const hipc::MemContext &mctx, const DomainQuery &dom_query,
                const BucketId &bkt_id, const chi::string &blob_name,
-               float score) {
-    FullPtr<StageInTask> task =
-        AsyncStageIn(mctx, dom_query, bkt_id, blob_name, score);
+               size_t blob_off, size_t data_size, float score) {
+    FullPtr<StageInTask> task = AsyncStageIn(mctx, dom_query, bkt_id,
+                                             blob_name, blob_off, data_size,
+                                             score);
     task->Wait();
     CHI_CLIENT->DelTask(mctx, task);
   }
@@ -56,6 +56,10 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       TagFlush(reinterpret_cast<TagFlushTask *>(task), rctx);
       break;
     }
+    case Method::kTagTruncate: {
+      TagTruncate(reinterpret_cast<TagTruncateTask *>(task), rctx);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       GetOrCreateBlobId(reinterpret_cast<GetOrCreateBlobIdTask *>(task), rctx);
       break;
@@ -68,6 +72,10 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       GetBlobName(reinterpret_cast<GetBlobNameTask *>(task), rctx);
       break;
     }
+    case Method::kPrefetchBlob: {
+      PrefetchBlob(reinterpret_cast<PrefetchBlobTask *>(task), rctx);
+      break;
+    }
     case Method::kGetBlobSize: {
       GetBlobSize(reinterpret_cast<GetBlobSizeTask *>(task), rctx);
       break;
@@ -124,6 +132,14 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       FlushData(reinterpret_cast<FlushDataTask *>(task), rctx);
       break;
     }
+    case Method::kPutBlobBatch: {
+      PutBlobBatch(reinterpret_cast<PutBlobBatchTask *>(task), rctx);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      GetBlobBatch(reinterpret_cast<GetBlobBatchTask *>(task), rctx);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       PollBlobMetadata(reinterpret_cast<PollBlobMetadataTask *>(task), rctx);
       break;
@@ -213,6 +229,10 @@ void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx)
       MonitorTagFlush(mode, reinterpret_cast<TagFlushTask *>(task), rctx);
       break;
     }
+    case Method::kTagTruncate: {
+      MonitorTagTruncate(mode, reinterpret_cast<TagTruncateTask *>(task), rctx);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       MonitorGetOrCreateBlobId(mode, reinterpret_cast<GetOrCreateBlobIdTask *>(task), rctx);
       break;
@@ -225,6 +245,10 @@ void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx)
       MonitorGetBlobName(mode, reinterpret_cast<GetBlobNameTask *>(task), rctx);
       break;
     }
+    case Method::kPrefetchBlob: {
+      MonitorPrefetchBlob(mode, reinterpret_cast<PrefetchBlobTask *>(task), rctx);
+      break;
+    }
     case Method::kGetBlobSize: {
       MonitorGetBlobSize(mode, reinterpret_cast<GetBlobSizeTask *>(task), rctx);
       break;
@@ -281,6 +305,14 @@ void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx)
       MonitorFlushData(mode, reinterpret_cast<FlushDataTask *>(task), rctx);
       break;
     }
+    case Method::kPutBlobBatch: {
+      MonitorPutBlobBatch(mode, reinterpret_cast<PutBlobBatchTask *>(task), rctx);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      MonitorGetBlobBatch(mode, reinterpret_cast<GetBlobBatchTask *>(task), rctx);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       MonitorPollBlobMetadata(mode, reinterpret_cast<PollBlobMetadataTask *>(task), rctx);
       break;
@@ -370,6 +402,10 @@ void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
       CHI_CLIENT->DelTask<TagFlushTask>(mctx, reinterpret_cast<TagFlushTask *>(task));
       break;
     }
+    case Method::kTagTruncate: {
+      CHI_CLIENT->DelTask<TagTruncateTask>(mctx, reinterpret_cast<TagTruncateTask *>(task));
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       CHI_CLIENT->DelTask<GetOrCreateBlobIdTask>(mctx, reinterpret_cast<GetOrCreateBlobIdTask *>(task));
       break;
@@ -382,6 +418,10 @@ void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
       CHI_CLIENT->DelTask<GetBlobNameTask>(mctx, reinterpret_cast<GetBlobNameTask *>(task));
       break;
     }
+    case Method::kPrefetchBlob: {
+      CHI_CLIENT->DelTask<PrefetchBlobTask>(mctx, reinterpret_cast<PrefetchBlobTask *>(task));
+      break;
+    }
     case Method::kGetBlobSize: {
       CHI_CLIENT->DelTask<GetBlobSizeTask>(mctx, reinterpret_cast<GetBlobSizeTask *>(task));
       break;
@@ -438,6 +478,14 @@ void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
       CHI_CLIENT->DelTask<FlushDataTask>(mctx, reinterpret_cast<FlushDataTask *>(task));
       break;
     }
+    case Method::kPutBlobBatch: {
+      CHI_CLIENT->DelTask<PutBlobBatchTask>(mctx, reinterpret_cast<PutBlobBatchTask *>(task));
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      CHI_CLIENT->DelTask<GetBlobBatchTask>(mctx, reinterpret_cast<GetBlobBatchTask *>(task));
+      break;
+    }
     case Method::kPollBlobMetadata: {
       CHI_CLIENT->DelTask<PollBlobMetadataTask>(mctx, reinterpret_cast<PollBlobMetadataTask *>(task));
       break;
@@ -553,6 +601,12 @@ void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) ove
         reinterpret_cast<TagFlushTask*>(dup_task), deep);
       break;
     }
+    case Method::kTagTruncate: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const TagTruncateTask*>(orig_task), 
+        reinterpret_cast<TagTruncateTask*>(dup_task), deep);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       chi::CALL_COPY_START(
         reinterpret_cast<const GetOrCreateBlobIdTask*>(orig_task), 
@@ -571,6 +625,12 @@ void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) ove
         reinterpret_cast<GetBlobNameTask*>(dup_task), deep);
       break;
     }
+    case Method::kPrefetchBlob: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const PrefetchBlobTask*>(orig_task), 
+        reinterpret_cast<PrefetchBlobTask*>(dup_task), deep);
+      break;
+    }
     case Method::kGetBlobSize: {
       chi::CALL_COPY_START(
         reinterpret_cast<const GetBlobSizeTask*>(orig_task), 
@@ -655,6 +715,18 @@ void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) ove
         reinterpret_cast<FlushDataTask*>(dup_task), deep);
       break;
     }
+    case Method::kPutBlobBatch: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const PutBlobBatchTask*>(orig_task), 
+        reinterpret_cast<PutBlobBatchTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const GetBlobBatchTask*>(orig_task), 
+        reinterpret_cast<GetBlobBatchTask*>(dup_task), deep);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       chi::CALL_COPY_START(
         reinterpret_cast<const PollBlobMetadataTask*>(orig_task), 
@@ -760,6 +832,10 @@ void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bo
       chi::CALL_NEW_COPY_START(reinterpret_cast<const TagFlushTask*>(orig_task), dup_task, deep);
       break;
     }
+    case Method::kTagTruncate: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const TagTruncateTask*>(orig_task), dup_task, deep);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       chi::CALL_NEW_COPY_START(reinterpret_cast<const GetOrCreateBlobIdTask*>(orig_task), dup_task, deep);
       break;
@@ -772,6 +848,10 @@ void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bo
       chi::CALL_NEW_COPY_START(reinterpret_cast<const GetBlobNameTask*>(orig_task), dup_task, deep);
       break;
     }
+    case Method::kPrefetchBlob: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const PrefetchBlobTask*>(orig_task), dup_task, deep);
+      break;
+    }
     case Method::kGetBlobSize: {
       chi::CALL_NEW_COPY_START(reinterpret_cast<const GetBlobSizeTask*>(orig_task), dup_task, deep);
       break;
@@ -828,6 +908,14 @@ void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bo
       chi::CALL_NEW_COPY_START(reinterpret_cast<const FlushDataTask*>(orig_task), dup_task, deep);
       break;
     }
+    case Method::kPutBlobBatch: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const PutBlobBatchTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const GetBlobBatchTask*>(orig_task), dup_task, deep);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       chi::CALL_NEW_COPY_START(reinterpret_cast<const PollBlobMetadataTask*>(orig_task), dup_task, deep);
       break;
@@ -919,6 +1007,10 @@ void SaveStart(
       ar << *reinterpret_cast<TagFlushTask*>(task);
       break;
     }
+    case Method::kTagTruncate: {
+      ar << *reinterpret_cast<TagTruncateTask*>(task);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       ar << *reinterpret_cast<GetOrCreateBlobIdTask*>(task);
       break;
@@ -931,6 +1023,10 @@ void SaveStart(
       ar << *reinterpret_cast<GetBlobNameTask*>(task);
       break;
     }
+    case Method::kPrefetchBlob: {
+      ar << *reinterpret_cast<PrefetchBlobTask*>(task);
+      break;
+    }
     case Method::kGetBlobSize: {
       ar << *reinterpret_cast<GetBlobSizeTask*>(task);
       break;
@@ -987,6 +1083,14 @@ void SaveStart(
       ar << *reinterpret_cast<FlushDataTask*>(task);
       break;
     }
+    case Method::kPutBlobBatch: {
+      ar << *reinterpret_cast<PutBlobBatchTask*>(task);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      ar << *reinterpret_cast<GetBlobBatchTask*>(task);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       ar << *reinterpret_cast<PollBlobMetadataTask*>(task);
       break;
@@ -1103,6 +1207,12 @@ TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<TagFlushTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kTagTruncate: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<TagTruncateTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<TagTruncateTask*>(task_ptr.ptr_);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<GetOrCreateBlobIdTask>(
              HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
@@ -1121,6 +1231,12 @@ TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<GetBlobNameTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kPrefetchBlob: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PrefetchBlobTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<PrefetchBlobTask*>(task_ptr.ptr_);
+      break;
+    }
     case Method::kGetBlobSize: {
       task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<GetBlobSizeTask>(
              HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
@@ -1205,6 +1321,18 @@ TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<FlushDataTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kPutBlobBatch: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PutBlobBatchTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<PutBlobBatchTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<GetBlobBatchTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<GetBlobBatchTask*>(task_ptr.ptr_);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PollBlobMetadataTask>(
              HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
@@ -1311,6 +1439,10 @@ void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
       ar << *reinterpret_cast<TagFlushTask*>(task);
       break;
     }
+    case Method::kTagTruncate: {
+      ar << *reinterpret_cast<TagTruncateTask*>(task);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       ar << *reinterpret_cast<GetOrCreateBlobIdTask*>(task);
       break;
@@ -1323,6 +1455,10 @@ void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
       ar << *reinterpret_cast<GetBlobNameTask*>(task);
       break;
     }
+    case Method::kPrefetchBlob: {
+      ar << *reinterpret_cast<PrefetchBlobTask*>(task);
+      break;
+    }
     case Method::kGetBlobSize: {
       ar << *reinterpret_cast<GetBlobSizeTask*>(task);
       break;
@@ -1379,6 +1515,14 @@ void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
       ar << *reinterpret_cast<FlushDataTask*>(task);
       break;
     }
+    case Method::kPutBlobBatch: {
+      ar << *reinterpret_cast<PutBlobBatchTask*>(task);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      ar << *reinterpret_cast<GetBlobBatchTask*>(task);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       ar << *reinterpret_cast<PollBlobMetadataTask*>(task);
       break;
@@ -1468,6 +1612,10 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
       ar >> *reinterpret_cast<TagFlushTask*>(task);
       break;
     }
+    case Method::kTagTruncate: {
+      ar >> *reinterpret_cast<TagTruncateTask*>(task);
+      break;
+    }
     case Method::kGetOrCreateBlobId: {
       ar >> *reinterpret_cast<GetOrCreateBlobIdTask*>(task);
       break;
@@ -1480,6 +1628,10 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
       ar >> *reinterpret_cast<GetBlobNameTask*>(task);
       break;
     }
+    case Method::kPrefetchBlob: {
+      ar >> *reinterpret_cast<PrefetchBlobTask*>(task);
+      break;
+    }
     case Method::kGetBlobSize: {
       ar >> *reinterpret_cast<GetBlobSizeTask*>(task);
       break;
@@ -1536,6 +1688,14 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
       ar >> *reinterpret_cast<FlushDataTask*>(task);
       break;
     }
+    case Method::kPutBlobBatch: {
+      ar >> *reinterpret_cast<PutBlobBatchTask*>(task);
+      break;
+    }
+    case Method::kGetBlobBatch: {
+      ar >> *reinterpret_cast<GetBlobBatchTask*>(task);
+      break;
+    }
     case Method::kPollBlobMetadata: {
       ar >> *reinterpret_cast<PollBlobMetadataTask*>(task);
       break;
@@ -14,6 +14,7 @@ struct Method : public TaskMethod {
   TASK_METHOD_T kTagUpdateSize = 19;
   TASK_METHOD_T kTagGetContainedBlobIds = 20;
   TASK_METHOD_T kTagFlush = 21;
+  TASK_METHOD_T kTagTruncate = 22;
   TASK_METHOD_T kGetOrCreateBlobId = 30;
   TASK_METHOD_T kGetBlobId = 31;
   TASK_METHOD_T kGetBlobName = 32;
@@ -31,6 +32,9 @@ struct Method : public TaskMethod {
   TASK_METHOD_T kReorganizeNode = 45;
   TASK_METHOD_T kFlushBlob = 46;
   TASK_METHOD_T kFlushData = 47;
+  TASK_METHOD_T kPutBlobBatch = 48;
+  TASK_METHOD_T kGetBlobBatch = 49;
+  TASK_METHOD_T kPrefetchBlob = 54;
   TASK_METHOD_T kPollBlobMetadata = 50;
   TASK_METHOD_T kPollTargetMetadata = 51;
   TASK_METHOD_T kPollTagMetadata = 52;
@@ -55,6 +55,60 @@ static inline u32 HashBlobNameOrId(const TagId &tag_id,
   }
 }
 
+/** Node ID bit marking a blob ID derived from a page index */
+#define HERMES_PAGE_BLOB_ID BIT_OPT(u32, 31)
+
+/** Bits of a page blob ID holding the tag's unique ID and the page index */
+#define HERMES_PAGE_ID_BITS 32
+
+/** Whether \a page of \a tag_id fits in a page blob ID */
+static inline bool HasPageBlobId(const TagId &tag_id, size_t page) {
+  return (page >> HERMES_PAGE_ID_BITS) == 0 &&
+         (tag_id.unique_ >> HERMES_PAGE_ID_BITS) == 0 &&
+         (tag_id.node_id_ & HERMES_PAGE_BLOB_ID) == 0;
+}
+
+/**
+ * The ID of the blob holding \a page of a paged tag. Clients compute it
+ * without contacting the runtime. It hashes like the page's blob name, so
+ * ID and name based requests for a page reach the same container. The ID
+ * keeps the tag's node, its unique ID and the page index whole, so two
+ * (tag, page) pairs never share an ID. Null if they do not fit, in which
+ * case the page must be addressed by its name (GetPageBlobName).
+ * */
+static inline BlobId GetPageBlobId(const TagId &tag_id, size_t page) {
+  if (!HasPageBlobId(tag_id, page)) {
+    return BlobId::GetNull();
+  }
+  return BlobId(tag_id.node_id_ | HERMES_PAGE_BLOB_ID,
+                HashBlobName(tag_id, GetPageBlobName(page)),
+                (tag_id.unique_ << HERMES_PAGE_ID_BITS) | page);
+}
+
+/** Whether \a blob_id was derived from a page index */
+static inline bool IsPageBlobId(const BlobId &blob_id) {
+  return !blob_id.IsNull() && (blob_id.node_id_ & HERMES_PAGE_BLOB_ID);
+}
+
+/** The page index of a page blob ID */
+static inline size_t GetPageIndex(const BlobId &blob_id) {
+  return blob_id.unique_ & ((u64(1) << HERMES_PAGE_ID_BITS) - 1);
+}
+
+/**
+ * The page blob ID of the blob named \a blob_name, or null if the name is
+ * not a page name. Pages created by name and by ID are then one blob.
+ * */
+template <typename StringT>
+static inline BlobId FindPageBlobId(const TagId &tag_id,
+                                    const StringT &blob_name) {
+  size_t page;
+  if (!ParsePageBlobName(blob_name, page)) {
+    return BlobId::GetNull();
+  }
+  return GetPageBlobId(tag_id, page);
+}
+
 /** Blob with ID */
 class BlobWithId {};
 
@@ -372,6 +426,7 @@ CHI_BEGIN(TagClearBlobs)
 /** A task to destroy all blobs in the tag */
 struct TagClearBlobsTask : public Task, TaskFlags<TF_SRL_SYM>, TagWithId {
   IN TagId tag_id_;
+  IN u64 generation_; /**< Set when the owner broadcasts a new generation */
 
   /** SHM default constructor */
   HSHM_INLINE explicit TagClearBlobsTask(
@@ -381,7 +436,8 @@ struct TagClearBlobsTask : public Task, TaskFlags<TF_SRL_SYM>, TagWithId {
   /** Emplace constructor */
   HSHM_INLINE explicit TagClearBlobsTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
-      const PoolId &pool_id, const DomainQuery &dom_query, TagId tag_id)
+      const PoolId &pool_id, const DomainQuery &dom_query, TagId tag_id,
+      u64 generation = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -393,15 +449,19 @@ struct TagClearBlobsTask : public Task, TaskFlags<TF_SRL_SYM>, TagWithId {
 
     // Custom params
     tag_id_ = tag_id;
+    generation_ = generation;
   }
 
   /** Duplicate message */
   void CopyStart(const TagClearBlobsTask &other, bool deep) {
     tag_id_ = other.tag_id_;
+    generation_ = other.generation_;
   }
 
   /** (De)serialize message call */
-  template <typename Ar> void SerializeStart(Ar &ar) { ar(tag_id_); }
+  template <typename Ar> void SerializeStart(Ar &ar) {
+    ar(tag_id_, generation_);
+  }
 
   /** (De)serialize message return */
   template <typename Ar> void SerializeEnd(Ar &ar) {}
@@ -579,6 +639,55 @@ struct TagFlushTask : public Task, TaskFlags<TF_SRL_SYM>, TagWithId {
 };
 CHI_END(TagFlush)
 
+CHI_BEGIN(TagTruncate)
+/** A task to truncate the pages of a tag to a new size */
+struct TagTruncateTask : public Task, TaskFlags<TF_SRL_SYM>, TagWithId {
+  IN TagId tag_id_;
+  IN size_t size_;
+  IN size_t page_size_;
+
+  /** SHM default constructor */
+  HSHM_INLINE explicit TagTruncateTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE explicit TagTruncateTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
+      const PoolId &pool_id, const DomainQuery &dom_query,
+      const TagId &tag_id, size_t size, size_t page_size)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kTagTruncate;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    tag_id_ = tag_id;
+    size_ = size;
+    page_size_ = page_size;
+  }
+
+  /** Duplicate message */
+  void CopyStart(const TagTruncateTask &other, bool deep) {
+    tag_id_ = other.tag_id_;
+    size_ = other.size_;
+    page_size_ = other.page_size_;
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar> void SerializeStart(Ar &ar) {
+    ar(tag_id_, size_, page_size_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar> void SerializeEnd(Ar &ar) {}
+};
+CHI_END(TagTruncate)
+
 /**
  * ========================================
  * BLOB Tasks
@@ -594,6 +703,8 @@ CHI_END(TagFlush)
 #define HERMES_BLOB_DID_CREATE BIT_OPT(u32, 6)
 #define HERMES_GET_BLOB_ID BIT_OPT(u32, 7)
 #define HERMES_USER_SCORE_STATIONARY BIT_OPT(u32, 9)
+#define HERMES_IS_STAGE_IN BIT_OPT(u32, 10)
+#define HERMES_GET_BLOB_SIZE BIT_OPT(u32, 11)
 
 CHI_BEGIN(GetOrCreateBlobId)
 /**
@@ -747,6 +858,59 @@ struct GetBlobNameTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
 };
 CHI_END(GetBlobName)
 
+CHI_BEGIN(PrefetchBlob)
+/**
+ * Stage in the page blob \a blob_id of \a tag_id ahead of a reader,
+ * creating it if needed. Does nothing if the blob was already staged in.
+ * */
+struct PrefetchBlobTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
+  IN TagId tag_id_;
+  IN BlobId blob_id_;
+  IN float score_;
+
+  /** SHM default constructor */
+  HSHM_INLINE explicit PrefetchBlobTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE explicit PrefetchBlobTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
+      const PoolId &pool_id, const DomainQuery &dom_query, const TagId &tag_id,
+      const BlobId &blob_id, float score, u32 task_flags = 0)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kPrefetchBlob;
+    task_flags_.SetBits(task_flags);
+    dom_query_ = dom_query;
+
+    // Custom
+    tag_id_ = tag_id;
+    blob_id_ = blob_id;
+    score_ = score;
+  }
+
+  /** Duplicate message */
+  void CopyStart(const PrefetchBlobTask &other, bool deep) {
+    tag_id_ = other.tag_id_;
+    blob_id_ = other.blob_id_;
+    score_ = other.score_;
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar> void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(tag_id_, blob_id_, score_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar> void SerializeEnd(Ar &ar) {}
+};
+CHI_END(PrefetchBlob)
+
 CHI_BEGIN(GetBlobSize)
 /** Get \a score from \a blob_id BLOB id */
 struct GetBlobSizeTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
@@ -946,9 +1110,12 @@ CHI_END(BlobHasTag)
 CHI_BEGIN(TruncateBlob)
 /** A task to truncate a blob */
 struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
+  CLS_CONST u32 kKeepTagSize = BIT_OPT(u32, 0);
+
   IN TagId tag_id_;
   IN BlobId blob_id_;
   IN u64 size_;
+  IN bitfield32_t flags_;
 
   /** SHM default constructor */
   HSHM_INLINE explicit TruncateBlobTask(
@@ -959,20 +1126,22 @@ struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
   HSHM_INLINE explicit TruncateBlobTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
       const PoolId &pool_id, const DomainQuery &dom_query, const TagId &tag_id,
-      const BlobId &blob_id, u64 size)
+      const BlobId &blob_id, u64 size, u32 blob_flags = 0,
+      u32 task_flags = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
     prio_ = TaskPrioOpt::kLowLatency;
     pool_ = pool_id;
     method_ = Method::kTruncateBlob;
-    task_flags_.SetBits(0);
+    task_flags_.SetBits(task_flags);
     dom_query_ = dom_query;
 
     // Custom params
     tag_id_ = tag_id;
     blob_id_ = blob_id;
     size_ = size;
+    flags_.SetBits(blob_flags);
   }
 
   /** Duplicate message */
@@ -980,11 +1149,12 @@ struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
     tag_id_ = other.tag_id_;
     blob_id_ = other.blob_id_;
     size_ = other.size_;
+    flags_ = other.flags_;
   }
 
   /** (De)serialize message call */
   template <typename Ar> void SerializeStart(Ar &ar) {
-    ar(tag_id_, blob_id_, size_);
+    ar(tag_id_, blob_id_, size_, flags_);
   }
 
   /** (De)serialize message return */
@@ -996,6 +1166,7 @@ CHI_BEGIN(DestroyBlob)
 /** A task to destroy a blob */
 struct DestroyBlobTask : public Task, TaskFlags<TF_SRL_SYM>, BlobWithId {
   CLS_CONST u32 kKeepInTag = BIT_OPT(u32, 0);
+  CLS_CONST u32 kStaleOnly = BIT_OPT(u32, 1);
 
   IN TagId tag_id_;
   IN BlobId blob_id_;
@@ -1105,6 +1276,8 @@ CHI_END(ReorganizeBlob)
 CHI_BEGIN(ReorganizeNode)
 /** The ReorganizeNodeTask task */
 struct ReorganizeNodeTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN u32 lane_hash_;
+
   /** SHM default constructor */
   HSHM_INLINE explicit ReorganizeNodeTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
@@ -1113,24 +1286,29 @@ struct ReorganizeNodeTask : public Task, TaskFlags<TF_SRL_SYM> {
   /** Emplace constructor */
   HSHM_INLINE explicit ReorganizeNodeTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
-      const PoolId &pool_id, const DomainQuery &dom_query)
+      const PoolId &pool_id, const DomainQuery &dom_query, size_t period_ms,
+      u32 lane_hash = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
     prio_ = TaskPrioOpt::kLowLatency;
     pool_ = pool_id;
     method_ = Method::kReorganizeNode;
-    task_flags_.SetBits(0);
+    task_flags_.SetBits(TASK_LONG_RUNNING);
     dom_query_ = dom_query;
+    SetPeriodMs(period_ms);
 
     // Custom
+    lane_hash_ = lane_hash;
   }
 
   /** Duplicate message */
-  void CopyStart(const ReorganizeNodeTask &other, bool deep) {}
+  void CopyStart(const ReorganizeNodeTask &other, bool deep) {
+    lane_hash_ = other.lane_hash_;
+  }
 
   /** (De)serialize message call */
-  template <typename Ar> void SerializeStart(Ar &ar) {}
+  template <typename Ar> void SerializeStart(Ar &ar) { ar(lane_hash_); }
 
   /** (De)serialize message return */
   template <typename Ar> void SerializeEnd(Ar &ar) {}
@@ -1462,6 +1640,8 @@ CHI_END(AppendBlob);
 CHI_BEGIN(FlushData)
 /** The FlushDataTask task */
 struct FlushDataTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN u32 lane_hash_;
+
   /** SHM default constructor */
   HSHM_INLINE explicit FlushDataTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
@@ -1470,7 +1650,8 @@ struct FlushDataTask : public Task, TaskFlags<TF_SRL_SYM> {
   /** Emplace constructor */
   HSHM_INLINE explicit FlushDataTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
-      const PoolId &pool_id, const DomainQuery &dom_query, int period_sec)
+      const PoolId &pool_id, const DomainQuery &dom_query, int period_sec,
+      u32 lane_hash = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -1482,19 +1663,170 @@ struct FlushDataTask : public Task, TaskFlags<TF_SRL_SYM> {
     SetPeriodSec(period_sec);
 
     // Custom
+    lane_hash_ = lane_hash;
   }
 
   /** Duplicate message */
-  void CopyStart(const FlushDataTask &other, bool deep) {}
+  void CopyStart(const FlushDataTask &other, bool deep) {
+    lane_hash_ = other.lane_hash_;
+  }
 
   /** (De)serialize message call */
-  template <typename Ar> void SerializeStart(Ar &ar) {}
+  template <typename Ar> void SerializeStart(Ar &ar) { ar(lane_hash_); }
 
   /** (De)serialize message return */
   template <typename Ar> void SerializeEnd(Ar &ar) {}
 };
 CHI_END(FlushData)
 
+/** A single blob operation in a PutBlobBatch or GetBlobBatch task */
+struct BlobBatchEntry {
+  BlobId blob_id_;        /**< ID of the blob (null to look up by name) */
+  size_t blob_off_;       /**< Offset in the blob */
+  size_t data_size_;      /**< Amount of data to put or get */
+  hipc::Pointer data_;    /**< SHM pointer to the data */
+  size_t name_off_ = 0;   /**< Offset of the blob name in the names buffer */
+  size_t name_size_ = 0;  /**< Length of the blob name */
+
+  /** Default constructor */
+  BlobBatchEntry() = default;
+
+  /** Emplace constructor */
+  BlobBatchEntry(const BlobId &blob_id, size_t blob_off, size_t data_size,
+                 const hipc::Pointer &data)
+      : blob_id_(blob_id),
+        blob_off_(blob_off),
+        data_size_(data_size),
+        data_(data) {}
+
+  /** Get the blob name out of the names buffer */
+  chi::string GetBlobName(const std::string &names) const {
+    return chi::string(names.substr(name_off_, name_size_));
+  }
+
+  /** Serialize everything but the data */
+  template <typename Ar> void serialize(Ar &ar) {
+    ar(blob_id_, blob_off_, data_size_, name_off_, name_size_);
+  }
+};
+
+/** Base task for batched blob I/O */
+template <int METHOD>
+struct BlobBatchTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN TagId tag_id_;
+  IN chi::ipc::string names_;
+  INOUT chi::ipc::vector<BlobBatchEntry> entries_;
+  IN float score_;
+  IN bitfield32_t flags_;
+
+  /** SHM default constructor */
+  HSHM_INLINE explicit BlobBatchTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), names_(alloc), entries_(alloc) {}
+
+  /** Emplace constructor */
+  template <typename StringT>
+  HSHM_INLINE explicit BlobBatchTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
+      const PoolId &pool_id, const DomainQuery &dom_query, const TagId &tag_id,
+      const std::vector<StringT> &blob_names,
+      const std::vector<BlobBatchEntry> &entries, float score, u32 task_flags,
+      u32 hermes_flags, const Context &ctx = Context())
+      : Task(alloc), names_(alloc), entries_(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = METHOD;
+    task_flags_.SetBits(task_flags | TASK_COROUTINE);
+    dom_query_ = dom_query;
+
+    // Custom params
+    tag_id_ = tag_id;
+    score_ = score;
+    flags_ = bitfield32_t(hermes_flags | ctx.flags_.bits_);
+    // Pack the blob names into a single buffer
+    std::string names;
+    entries_.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      BlobBatchEntry entry = entries[i];
+      if (i < blob_names.size()) {
+        entry.name_off_ = names.size();
+        entry.name_size_ = blob_names[i].size();
+        names.append(blob_names[i].data(), blob_names[i].size());
+      }
+      entries_.emplace_back(entry);
+    }
+    names_ = names;
+  }
+
+  /** Destructor */
+  HSHM_INLINE ~BlobBatchTask() {
+    if (!IsDataOwner()) {
+      return;
+    }
+    for (BlobBatchEntry &entry : entries_) {
+      if (!entry.data_.IsNull()) {
+        CHI_CLIENT->FreeBuffer(HSHM_MCTX, entry.data_);
+      }
+    }
+  }
+
+  /** Duplicate message */
+  void CopyStart(const BlobBatchTask &other, bool deep) {
+    tag_id_ = other.tag_id_;
+    names_ = other.names_;
+    entries_ = other.entries_;
+    score_ = other.score_;
+    flags_ = other.flags_;
+  }
+};
+
+CHI_BEGIN(PutBlobBatch)
+/** A task to put data in many blobs of one tag */
+struct PutBlobBatchTask : public BlobBatchTask<Method::kPutBlobBatch> {
+  using BlobBatchTask<Method::kPutBlobBatch>::BlobBatchTask;
+
+  /** (De)serialize message call */
+  template <typename Ar> void SerializeStart(Ar &ar) {
+    ar(tag_id_, names_, entries_, score_, flags_);
+    for (BlobBatchEntry &entry : entries_) {
+      ar.bulk(DT_WRITE, entry.data_, entry.data_size_);
+    }
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar> void SerializeEnd(Ar &ar) {
+    for (BlobBatchEntry &entry : entries_) {
+      ar(entry.blob_id_);
+    }
+  }
+};
+CHI_END(PutBlobBatch)
+
+CHI_BEGIN(GetBlobBatch)
+/** A task to get data from many blobs of one tag */
+struct GetBlobBatchTask : public BlobBatchTask<Method::kGetBlobBatch> {
+  using BlobBatchTask<Method::kGetBlobBatch>::BlobBatchTask;
+
+  /** (De)serialize message call */
+  template <typename Ar> void SerializeStart(Ar &ar) {
+    ar(tag_id_, names_, entries_, score_, flags_);
+    for (BlobBatchEntry &entry : entries_) {
+      ar.bulk(DT_EXPOSE, entry.data_, entry.data_size_);
+    }
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar> void SerializeEnd(Ar &ar) {
+    for (BlobBatchEntry &entry : entries_) {
+      ar.bulk(DT_WRITE, entry.data_, entry.data_size_);
+      ar(entry.blob_id_, entry.data_size_);
+    }
+  }
+};
+CHI_END(GetBlobBatch)
+
 /** Base task for various metadata queries */
 template <typename MD, int METHOD>
 struct PollMetadataTask : public Task, TaskFlags<TF_SRL_SYM> {
@@ -1721,6 +2053,8 @@ CHI_BEGIN(StageIn)
 struct StageInTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN hermes::BucketId bkt_id_;
   IN chi::ipc::string blob_name_;
+  IN size_t blob_off_;
+  IN size_t data_size_; /**< 0 stages in the rest of the page */
   IN float score_;
 
   /** SHM default constructor */
@@ -1733,7 +2067,9 @@ struct StageInTask : public Task, TaskFlags<TF_SRL_SYM> {
                                    const PoolId &pool_id,
                                    const DomainQuery &dom_query,
                                    const BucketId &bkt_id,
-                                   const chi::string &blob_name, float score)
+                                   const chi::string &blob_name,
+                                   size_t blob_off, size_t data_size,
+                                   float score)
       : Task(alloc), blob_name_(alloc, blob_name) {
     // Initialize task
     task_node_ = task_node;
@@ -1745,6 +2081,8 @@ struct StageInTask : public Task, TaskFlags<TF_SRL_SYM> {
 
     // Custom
     bkt_id_ = bkt_id;
+    blob_off_ = blob_off;
+    data_size_ = data_size;
     score_ = score;
   }
 
@@ -1752,12 +2090,14 @@ struct StageInTask : public Task, TaskFlags<TF_SRL_SYM> {
   void CopyStart(const StageInTask &other, bool deep) {
     bkt_id_ = other.bkt_id_;
     blob_name_ = other.blob_name_;
+    blob_off_ = other.blob_off_;
+    data_size_ = other.data_size_;
     score_ = other.score_;
   }
 
   /** (De)serialize message call */
   template <typename Ar> void SerializeStart(Ar &ar) {
-    ar(bkt_id_, blob_name_, score_);
+    ar(bkt_id_, blob_name_, blob_off_, data_size_, score_);
   }
 
   /** (De)serialize message return */
@@ -10,7 +10,11 @@
  * have access to the file, you may request a copy from help@hdfgroup.org.   *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <cmath>
+#include <fstream>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 #include "bdev/bdev_client.h"
 #include "chimaera/api/chimaera_runtime.h"
@@ -18,9 +22,13 @@
 #include "chimaera/monitor/monitor.h"
 #include "chimaera/work_orchestrator/work_orchestrator.h"
 #include "chimaera_admin/chimaera_admin_client.h"
+#include "hermes/apriori_schema.h"
+#include "hermes/buffer_cache.h"
 #include "hermes/data_stager/stager_factory.h"
 #include "hermes/dpe/dpe_factory.h"
 #include "hermes/hermes.h"
+#include "hermes/metadata_index.h"
+#include "hermes/read_ahead.h"
 #include "hermes_core/hermes_core_client.h"
 
 /** NOTE(llogan): std::hash function for string. This is because NVCC is bugged
@@ -35,27 +43,183 @@ namespace hermes {
 
 #define HERMES_LANES 32
 
-struct FlushInfo {
-  BlobInfo *blob_info_;
-  FullPtr<StageOutTask> stage_task_;
-  size_t mod_count_;
+/** A runtime buffer reused across the blobs of one flush */
+struct FlushBuffer {
+  FullPtr<char> data_;
+  size_t size_ = 0;
+
+  /** Grow the buffer to at least \a size bytes */
+  void Reserve(size_t size) {
+    if (size <= size_) {
+      return;
+    }
+    if (size_ > 0) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data_.shm_);
+    }
+    data_ = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, size);
+    size_ = size;
+  }
+
+  /** Destructor */
+  ~FlushBuffer() {
+    if (size_ > 0) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data_.shm_);
+    }
+  }
+};
+
+/** The dirty range of a blob covered by part of a flush write */
+struct FlushSpan {
+  BlobInfo *blob_;
+  size_t blob_off_;           /**< Offset of the range in the blob */
+  size_t io_off_;             /**< Offset of the range in the write */
+  size_t size_;
+  hshm::big_uint last_flush_; /**< The blob's last flush before this one */
+};
+
+/**
+ * Flush writes staged in a FlushBuffer and submitted to a stager together.
+ * The buffer is only regrown once the writes in flight have completed.
+ * The ranges that failed or short writes left unwritten go to failed_.
+ * */
+struct FlushBatch {
+  FlushBuffer &buf_;
+  AbstractStager &stager_;
+  Client &client_;
+  TagId tag_id_;
+  std::vector<StageIo> ios_;
+  std::vector<std::vector<FlushSpan>> spans_; /**< The ranges of each io */
+  std::vector<FlushSpan> failed_;
+  size_t used_ = 0;
+  size_t max_bytes_;
+
+  FlushBatch(FlushBuffer &buf, AbstractStager &stager, Client &client,
+             const TagId &tag_id, size_t max_bytes)
+      : buf_(buf),
+        stager_(stager),
+        client_(client),
+        tag_id_(tag_id),
+        max_bytes_(max_bytes) {}
+
+  /** Claim \a size bytes of the buffer, returning their offset */
+  size_t Reserve(Task *task, size_t size) {
+    if (used_ + size > buf_.size_) {
+      Flush(task);
+      buf_.Reserve(std::max(size, max_bytes_));
+    }
+    size_t off = used_;
+    used_ += size;
+    return off;
+  }
+
+  /**
+   * Queue a write of \a size bytes at \a buf_off of the buffer, holding
+   * the blob ranges \a spans
+   * */
+  void Add(const std::string &blob_name, size_t blob_off, size_t buf_off,
+           size_t size, std::vector<FlushSpan> spans) {
+    StageIo io;
+    io.blob_name_ = blob_name;
+    io.blob_off_ = blob_off;
+    io.data_ = buf_.data_.shm_ + buf_off;
+    io.size_ = size;
+    ios_.emplace_back(std::move(io));
+    spans_.emplace_back(std::move(spans));
+  }
+
+  /** Submit the queued writes and yield until they complete */
+  void Flush(Task *task) {
+    if (!ios_.empty()) {
+      stager_.Submit(HSHM_MCTX, client_, tag_id_, ios_);
+      while (!stager_.Reap(ios_)) {
+        task->Yield();
+      }
+      for (size_t i = 0; i < ios_.size(); ++i) {
+        StageIo &io = ios_[i];
+        size_t done = io.result_ > 0 ? (size_t)io.result_ : 0;
+        if (done >= io.size_) {
+          continue;
+        }
+        HELOG(kError, "Flushed {} of {} bytes of {} to tag {}", done,
+              io.size_, io.blob_name_, tag_id_);
+        for (FlushSpan span : spans_[i]) {
+          if (span.io_off_ + span.size_ <= done) {
+            continue;
+          }
+          size_t skip = done > span.io_off_ ? done - span.io_off_ : 0;
+          span.blob_off_ += skip;
+          span.size_ -= skip;
+          failed_.emplace_back(span);
+        }
+      }
+      ios_.clear();
+      spans_.clear();
+    }
+    used_ = 0;
+  }
+};
+
+/**
+ * Prefetcher state of a tag, kept in the lane owning the tag. The name is
+ * recorded when the tag is created on this node, or else looked up in the
+ * background the first time one of its pages is read.
+ * */
+struct TagPrefetch {
+  ReadAhead read_ahead_;
+  std::string name_; /**< Tag name, used by the apriori schema and traces */
+  FullPtr<GetTagNameTask> name_task_; /**< The lookup of name_ in flight */
+  std::vector<size_t> untraced_;      /**< Pages read before name_ was known */
+};
+
+/** The ID of a bucket named by an apriori rule, or its lookup in flight */
+struct AprioriTag {
+  TagId tag_id_;
+  FullPtr<GetTagIdTask> task_;
+};
+
+/** An in-flight stage-in of a blob and the number of tasks waiting on it */
+struct StageInWait {
+  std::vector<FullPtr<StageInTask>> tasks_; /**< One task per missing range */
+  size_t waiters_ = 0;
 };
 
 /** Type name simplification for the various map types */
 typedef std::unordered_map<chi::string, TagId> TAG_ID_MAP_T;
-typedef std::unordered_map<TagId, TagInfo> TAG_MAP_T;
-typedef std::unordered_map<chi::string, BlobId> BLOB_ID_MAP_T;
-typedef std::unordered_map<BlobId, BlobInfo> BLOB_MAP_T;
+typedef MetadataTable<TagId, TagInfo> TAG_MAP_T;
+typedef MetadataIndex<TagId, u64> TAG_GEN_MAP_T;
+typedef MetadataIndex<BlobNameKey, BlobId> BLOB_ID_MAP_T;
+typedef std::unordered_map<BlobNameKey, std::vector<BlobId>>
+    BLOB_ID_COLLISION_MAP_T;
+typedef MetadataTable<BlobId, BlobInfo> BLOB_MAP_T;
 typedef hipc::circular_mpsc_queue<IoStat> IO_PATTERN_LOG_T;
 typedef std::unordered_map<TagId, std::shared_ptr<AbstractStager>> STAGER_MAP_T;
+typedef std::unordered_map<TargetId, BufferCache> BUFFER_CACHE_MAP_T;
+typedef std::unordered_set<BlobId> DIRTY_SET_T;
+typedef std::unordered_map<TagId, TagPrefetch> PREFETCH_MAP_T;
+typedef std::unordered_map<std::string, AprioriTag> APRIORI_TAG_MAP_T;
+typedef std::unordered_map<BlobId, StageInWait> STAGE_IN_MAP_T;
 
 struct HermesLane {
   TAG_ID_MAP_T tag_id_map_;
   TAG_MAP_T tag_map_;
+  TAG_GEN_MAP_T tag_gen_map_;
+  std::vector<TagId> stale_tags_;
   BLOB_ID_MAP_T blob_id_map_;
+  BLOB_ID_COLLISION_MAP_T blob_id_collisions_;
   BLOB_MAP_T blob_map_;
   STAGER_MAP_T stager_map_;
+  BUFFER_CACHE_MAP_T buffer_caches_;
+  DIRTY_SET_T dirty_blobs_; /**< Staged blobs modified since their flush */
+  PREFETCH_MAP_T prefetch_; /**< Prefetcher state of the lane's tags */
+  APRIORI_TAG_MAP_T apriori_tags_; /**< Apriori buckets hashed to the lane */
+  std::string trace_buf_; /**< I/O trace records not yet written */
+  size_t trace_dropped_ = 0; /**< Records dropped since the last flush */
+  STAGE_IN_MAP_T stage_ins_; /**< Stage-ins of the lane's blobs in flight */
   chi::CoMutex stager_map_lock_;
+  chi::CoMutex dirty_lock_;
+  chi::CoMutex prefetch_lock_;
+  chi::CoMutex stage_in_lock_;
+  chi::CoMutex trace_lock_;
   chi::CoRwLock tag_map_lock_;
   chi::CoRwLock blob_map_lock_;
 };
@@ -63,21 +227,102 @@ struct HermesLane {
 class Server : public Module {
 public:
   CLS_CONST LaneGroupId kDefaultGroup = 0;
+  CLS_CONST size_t kMaxReclaimPerFlush = 4096;
+  CLS_CONST size_t kTraceBufSize = KILOBYTES(64);
   Client client_;
   std::vector<HermesLane> tls_;
   std::atomic<u64> id_alloc_;
+  std::atomic<u64> tag_id_alloc_; /**< Dense, so tags get page blob IDs */
   std::vector<chi::bdev::Client> tgt_pools_;
   std::vector<TargetInfo> targets_;
   std::unordered_map<TargetId, TargetInfo *> target_map_;
   chi::RollingAverage monitor_[Method::kCount];
   IO_PATTERN_LOG_T io_pattern_;
   TargetInfo *fallback_target_;
+  AprioriSchema apriori_;
+  std::ofstream trace_;
+  std::mutex trace_lock_;
 
 private:
-  /** Get the globally unique blob name */
-  const chi::string GetBlobNameWithBucket(const TagId &tag_id,
-                                          const chi::string &blob_name) {
-    return BlobInfo::GetBlobNameWithBucket(tag_id, blob_name);
+  /**
+   * Find the ID of a blob by name without building a string key. The full
+   * name is compared only against blobs whose fingerprint matches. A null ID
+   * in blob_id_map_ marks a fingerprint shared by several names of a tag.
+   * */
+  template <typename StringT>
+  BlobId FindBlobId(HermesLane &tls, const TagId &tag_id,
+                    const StringT &blob_name) {
+    BlobNameKey key(tag_id, blob_name);
+    BlobId blob_id;
+    if (!tls.blob_id_map_.Find(key, blob_id)) {
+      return BlobId::GetNull();
+    }
+    if (!blob_id.IsNull()) {
+      BlobInfo *blob_info = tls.blob_map_.Find(blob_id);
+      if (blob_info && blob_info->HasName(tag_id, blob_name)) {
+        return blob_id;
+      }
+      return BlobId::GetNull();
+    }
+    auto it = tls.blob_id_collisions_.find(key);
+    if (it == tls.blob_id_collisions_.end()) {
+      return BlobId::GetNull();
+    }
+    for (BlobId &collided_id : it->second) {
+      BlobInfo *blob_info = tls.blob_map_.Find(collided_id);
+      if (blob_info && blob_info->HasName(tag_id, blob_name)) {
+        return collided_id;
+      }
+    }
+    return BlobId::GetNull();
+  }
+
+  /** Add a blob to the name index */
+  void AddBlobId(HermesLane &tls, const BlobInfo &blob_info) {
+    BlobNameKey key = blob_info.GetBlobNameKey();
+    BlobId cur_id;
+    if (!tls.blob_id_map_.Find(key, cur_id)) {
+      tls.blob_id_map_.Emplace(key, blob_info.blob_id_);
+      return;
+    }
+    std::vector<BlobId> &collided_ids = tls.blob_id_collisions_[key];
+    if (!cur_id.IsNull()) {
+      HILOG(kDebug, "Blob name fingerprint collision in tag {}",
+            blob_info.tag_id_);
+      collided_ids.emplace_back(cur_id);
+      tls.blob_id_map_.Update(key, BlobId::GetNull());
+    }
+    collided_ids.emplace_back(blob_info.blob_id_);
+  }
+
+  /** Remove a blob from the name index */
+  void RemoveBlobId(HermesLane &tls, const BlobInfo &blob_info) {
+    BlobNameKey key = blob_info.GetBlobNameKey();
+    BlobId cur_id;
+    if (!tls.blob_id_map_.Find(key, cur_id)) {
+      return;
+    }
+    if (!cur_id.IsNull()) {
+      tls.blob_id_map_.Erase(key);
+      return;
+    }
+    auto it = tls.blob_id_collisions_.find(key);
+    if (it == tls.blob_id_collisions_.end()) {
+      tls.blob_id_map_.Erase(key);
+      return;
+    }
+    std::vector<BlobId> &collided_ids = it->second;
+    collided_ids.erase(std::remove(collided_ids.begin(), collided_ids.end(),
+                                   blob_info.blob_id_),
+                       collided_ids.end());
+    if (collided_ids.size() <= 1) {
+      if (collided_ids.empty()) {
+        tls.blob_id_map_.Erase(key);
+      } else {
+        tls.blob_id_map_.Update(key, collided_ids[0]);
+      }
+      tls.blob_id_collisions_.erase(it);
+    }
   }
 
 public:
@@ -106,13 +351,17 @@ public:
     // map assignment. We need to reserve here, or else the vector
     // will resize and cause the map to be erronous.
     targets_.reserve(128);
-    for (chi::bdev::Client &tgt_pool : tgt_pools_) {
+    for (size_t dev_id = 0; dev_id < tgt_pools_.size(); ++dev_id) {
+      chi::bdev::Client &tgt_pool = tgt_pools_[dev_id];
       targets_.emplace_back();
       TargetInfo &target = targets_.back();
       target.client_ = tgt_pool;
       target.dom_query_ = DomainQuery::GetLocalHash(0);
       target.id_ = target.client_.pool_id_;
       target.id_.node_id_ = CHI_CLIENT->node_id_;
+      DeviceInfo &dev = HERMES_SERVER_CONF.devices_[dev_id];
+      target.borg_min_thresh_ = dev.borg_min_thresh_;
+      target.borg_max_thresh_ = dev.borg_max_thresh_;
       if (target_map_.find(target.id_) != target_map_.end()) {
         targets_.pop_back();
         continue;
@@ -130,9 +379,57 @@ public:
       target.stats_ = &target.poll_stats_->stats_;
       target_map_[target.id_] = &target;
       HILOG(kInfo, "Got stats for target: {}", target.id_);
+      // Give each lane its own cache of free blocks of the target
+      size_t share =
+          BufferCache::GetCacheShare(target.stats_->max_cap_, HERMES_LANES);
+      for (HermesLane &tls : tls_) {
+        tls.buffer_caches_.emplace(
+            target.id_, BufferCache(dev.slab_sizes_, dev.block_size_, share));
+      }
     }
     // TODO(llogan): We should sort targets first
     fallback_target_ = &targets_.back();
+    ScoreTargets();
+  }
+  /**
+   * Score targets by their rank in write bandwidth, so that N targets
+   * split the blob score range [0, 1] into N even bands and the slowest
+   * target scores 0. The DPE only places a blob on targets scoring at
+   * most the blob's score.
+   * */
+  void ScoreTargets() {
+    std::vector<TargetInfo *> ranked;
+    for (TargetInfo &target : targets_) {
+      ranked.emplace_back(&target);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const TargetInfo *a, const TargetInfo *b) {
+                       return a->stats_->write_bw_ > b->stats_->write_bw_;
+                     });
+    for (size_t rank = 0; rank < ranked.size(); ++rank) {
+      ranked[rank]->score_ = (float)(ranked.size() - 1 - rank) / ranked.size();
+    }
+  }
+  /** Load the apriori schema and open the I/O trace, if configured */
+  void InitPrefetcher() {
+    config::PrefetchInfo &prefetch = HERMES_SERVER_CONF.prefetcher_;
+    if (prefetch.enabled_ && !prefetch.apriori_schema_path_.empty()) {
+      if (!apriori_.Load(prefetch.apriori_schema_path_)) {
+        HELOG(kError, "Failed to load apriori schema {}",
+              prefetch.apriori_schema_path_);
+      } else {
+        HILOG(kInfo, "Loaded {} apriori prefetch rules", apriori_.size());
+      }
+    }
+    if (!prefetch.trace_path_.empty()) {
+      // Each node records its own trace
+      std::string path = hshm::Formatter::format(
+          "{}.{}", prefetch.trace_path_, CHI_CLIENT->node_id_);
+      trace_.open(path, std::ios::out | std::ios::app);
+      if (!trace_) {
+        HELOG(kError, "Failed to open I/O trace {}", path);
+      }
+    }
   }
   /** Construct hermes_core */
   void Create(CreateTask *task, RunContext &rctx) {
@@ -141,25 +438,169 @@ public:
     client_.Init(pool_id_);
     CreateLaneGroup(kDefaultGroup, HERMES_LANES, QUEUE_LOW_LATENCY);
     tls_.resize(HERMES_LANES);
+    const config::MdmInfo &mdm = HERMES_CONF->server_config_.mdm_;
+    for (HermesLane &tls : tls_) {
+      tls.blob_id_map_.Reserve(mdm.num_blobs_ / HERMES_LANES);
+      tls.blob_map_.Reserve(mdm.num_blobs_ / HERMES_LANES);
+      tls.tag_map_.Reserve(mdm.num_bkts_ / HERMES_LANES);
+    }
     io_pattern_.resize(8192);
+    InitPrefetcher();
     CreateTargetPools();
     CreateTargetNeighborhood();
-    client_.AsyncFlushData(
-        HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-        HERMES_CONF->server_config_.borg_.flush_period_); // OK
+    for (u32 lane_id = 0; lane_id < HERMES_LANES; ++lane_id) {
+      client_.AsyncFlushData(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
+                             HERMES_CONF->server_config_.borg_.flush_period_,
+                             lane_id); // OK
+      client_.AsyncReorganizeNode(
+          HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
+          HERMES_CONF->server_config_.borg_.blob_reorg_period_,
+          lane_id); // OK
+    }
   }
   void MonitorCreate(MonitorModeId mode, CreateTask *task, RunContext &rctx) {}
   CHI_END(Create)
 
+  /**
+   * Remix a blob / tag hash before selecting a lane. The same hash also
+   * selects the node, so without remixing every blob owned by a node would
+   * fall into the same residue class of lanes.
+   * */
+  static u32 LaneHash(u32 hash) {
+    return static_cast<u32>((hash * 0x9E3779B97F4A7C15ull) >> 32);
+  }
+
+  /** Get the lane-local metadata that owns a blob / tag hash */
+  HermesLane &GetLaneTls(u32 hash) {
+    Lane *lane =
+        GetLaneByHash(kDefaultGroup, TaskPrioOpt::kLowLatency, LaneHash(hash));
+    return tls_[lane->lane_id_];
+  }
+
+  /** Get the lane hash of a task addressing a blob by name or ID */
+  template <typename TaskT> static u32 BlobLaneHash(const Task *task) {
+    auto *blob_task = reinterpret_cast<const TaskT *>(task);
+    return HashBlobNameOrId(blob_task->tag_id_, blob_task->blob_name_,
+                            blob_task->blob_id_);
+  }
+
+  /** Get the lane hash of a task addressing a blob by ID */
+  template <typename TaskT> static u32 BlobIdLaneHash(const Task *task) {
+    return reinterpret_cast<const TaskT *>(task)->blob_id_.hash_;
+  }
+
+  /** Get the lane hash of a task addressing a tag by name */
+  template <typename TaskT> static u32 TagNameLaneHash(const Task *task) {
+    return HashTagName(reinterpret_cast<const TaskT *>(task)->tag_name_);
+  }
+
+  /** Get the lane hash of a task addressing a tag by ID */
+  template <typename TaskT> static u32 TagIdLaneHash(const Task *task) {
+    return reinterpret_cast<const TaskT *>(task)->tag_id_.hash_;
+  }
+
+  /** Get the lane hash of a staging task */
+  template <typename TaskT> static u32 StagerLaneHash(const Task *task) {
+    return reinterpret_cast<const TaskT *>(task)->bkt_id_.hash_;
+  }
+
+  /** Get the hash of the blob / tag a task operates on */
+  static u32 GetTaskHash(const Task *task) {
+    switch (task->method_) {
+    case Method::kGetOrCreateTag:
+      return TagNameLaneHash<GetOrCreateTagTask>(task);
+    case Method::kGetTagId:
+      return TagNameLaneHash<GetTagIdTask>(task);
+    case Method::kGetTagName:
+      return TagIdLaneHash<GetTagNameTask>(task);
+    case Method::kDestroyTag:
+      return TagIdLaneHash<DestroyTagTask>(task);
+    case Method::kTagAddBlob:
+      return TagIdLaneHash<TagAddBlobTask>(task);
+    case Method::kTagRemoveBlob:
+      return TagIdLaneHash<TagRemoveBlobTask>(task);
+    case Method::kTagClearBlobs:
+      return TagIdLaneHash<TagClearBlobsTask>(task);
+    case Method::kTagGetSize:
+      return TagIdLaneHash<TagGetSizeTask>(task);
+    case Method::kTagUpdateSize:
+      return TagIdLaneHash<TagUpdateSizeTask>(task);
+    case Method::kTagGetContainedBlobIds:
+      return TagIdLaneHash<TagGetContainedBlobIdsTask>(task);
+    case Method::kTagFlush:
+      return TagIdLaneHash<TagFlushTask>(task);
+    case Method::kTagTruncate:
+      return TagIdLaneHash<TagTruncateTask>(task);
+    case Method::kAppendBlob:
+      return TagIdLaneHash<AppendBlobTask>(task);
+    case Method::kGetOrCreateBlobId:
+      return HashBlobName(
+          reinterpret_cast<const GetOrCreateBlobIdTask *>(task)->tag_id_,
+          reinterpret_cast<const GetOrCreateBlobIdTask *>(task)->blob_name_);
+    case Method::kGetBlobId:
+      return HashBlobName(
+          reinterpret_cast<const GetBlobIdTask *>(task)->tag_id_,
+          reinterpret_cast<const GetBlobIdTask *>(task)->blob_name_);
+    case Method::kGetBlobName:
+      return BlobIdLaneHash<GetBlobNameTask>(task);
+    case Method::kPrefetchBlob:
+      return BlobIdLaneHash<PrefetchBlobTask>(task);
+    case Method::kGetBlobSize:
+      return BlobLaneHash<GetBlobSizeTask>(task);
+    case Method::kGetBlobScore:
+      return BlobIdLaneHash<GetBlobScoreTask>(task);
+    case Method::kGetBlobBuffers:
+      return BlobIdLaneHash<GetBlobBuffersTask>(task);
+    case Method::kPutBlob:
+      return BlobLaneHash<PutBlobTask>(task);
+    case Method::kGetBlob:
+      return BlobLaneHash<GetBlobTask>(task);
+    case Method::kTruncateBlob:
+      return BlobIdLaneHash<TruncateBlobTask>(task);
+    case Method::kDestroyBlob:
+      return BlobIdLaneHash<DestroyBlobTask>(task);
+    case Method::kTagBlob:
+      return BlobIdLaneHash<TagBlobTask>(task);
+    case Method::kBlobHasTag:
+      return BlobIdLaneHash<BlobHasTagTask>(task);
+    case Method::kReorganizeBlob:
+      return BlobLaneHash<ReorganizeBlobTask>(task);
+    case Method::kFlushBlob:
+      return BlobIdLaneHash<FlushBlobTask>(task);
+    case Method::kPutBlobBatch:
+      return TagIdLaneHash<PutBlobBatchTask>(task);
+    case Method::kGetBlobBatch:
+      return TagIdLaneHash<GetBlobBatchTask>(task);
+    case Method::kRegisterStager:
+      return StagerLaneHash<RegisterStagerTask>(task);
+    case Method::kUnregisterStager:
+      return StagerLaneHash<UnregisterStagerTask>(task);
+    case Method::kStageIn:
+      return StagerLaneHash<StageInTask>(task);
+    case Method::kStageOut:
+      return StagerLaneHash<StageOutTask>(task);
+    default:
+      return 0;
+    }
+  }
+
   /** Route a task to a lane */
   Lane *MapTaskToLane(const Task *task) override {
-    // Route tasks to lanes based on their properties
-    // E.g., a strongly consistent filesystem could map tasks to a lane
-    // by the hash of an absolute filename path.
-
-    // Can I route put / get tasks to nodes here? I feel like yes.
-
-    return GetLaneByHash(kDefaultGroup, task->prio_, 0);
+    // Blob and tag metadata live in the lane owning their hash, so that
+    // independent blobs are served in parallel by different workers.
+    // Per-lane background tasks (e.g., FlushData) name their lane directly.
+    if (task->method_ == Method::kFlushData) {
+      return GetLaneByHash(
+          kDefaultGroup, task->prio_,
+          reinterpret_cast<const FlushDataTask *>(task)->lane_hash_);
+    }
+    if (task->method_ == Method::kReorganizeNode) {
+      return GetLaneByHash(
+          kDefaultGroup, task->prio_,
+          reinterpret_cast<const ReorganizeNodeTask *>(task)->lane_hash_);
+    }
+    return GetLaneByHash(kDefaultGroup, task->prio_,
+                         LaneHash(GetTaskHash(task)));
   }
 
   CHI_BEGIN(Destroy)
@@ -175,32 +616,28 @@ public:
    * ========================================
    * */
 
-  /** Get blob info struct */
-  BlobInfo *GetBlobInfo(const std::string &blob_name, BlobId blob_id) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    BLOB_MAP_T &blob_map = tls.blob_map_;
-    // Check if blob name is cached on this node
+  /**
+   * Whether a blob is cached on this node. Routing runs without the lane
+   * lock, so this only probes the lock-free indices and never dereferences
+   * a BlobInfo that a concurrent DestroyBlob may free. A fingerprint match
+   * is enough to route by name: the blob's lane resolves the full name.
+   * */
+  bool HasBlob(const TagId &tag_id, const std::string &blob_name,
+               const BlobId &blob_id) {
+    HermesLane &tls = GetLaneTls(HashBlobNameOrId(tag_id, blob_name, blob_id));
     if (!blob_name.empty()) {
-      auto it = blob_id_map.find(blob_name);
-      if (it == blob_id_map.end()) {
-        return nullptr;
-      }
-      blob_id = it->second;
+      BlobId found_id;
+      return tls.blob_id_map_.Find(BlobNameKey(tag_id, blob_name), found_id);
     }
-    // Check if blob ID is cached on this node
     if (!blob_id.IsNull()) {
-      auto it = blob_map.find(blob_id);
-      if (it != blob_map.end()) {
-        return &it->second;
-      }
+      return tls.blob_map_.Find(blob_id) != nullptr;
     }
-    return nullptr;
+    return false;
   }
 
   /** Get tag info struct */
   TagInfo *GetTagInfo(const std::string &tag_name, TagId tag_id) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    HermesLane &tls = GetLaneTls(HashTagNameOrId(tag_id, tag_name));
     TAG_ID_MAP_T &tag_id_map = tls.tag_id_map_;
     TAG_MAP_T &tag_map = tls.tag_map_;
     // Check if tag name is cached on this node
@@ -213,10 +650,7 @@ public:
     }
     // Check if tag ID is cached on this node
     if (!tag_id.IsNull()) {
-      auto it = tag_map.find(tag_id);
-      if (it != tag_map.end()) {
-        return &it->second;
-      }
+      return tag_map.Find(tag_id);
     }
     return nullptr;
   }
@@ -231,8 +665,7 @@ public:
     if constexpr (std::is_base_of_v<BlobWithName, TaskT>) {
       blob_name = task->blob_name_.str();
     }
-    BlobInfo *blob_info = GetBlobInfo(blob_name, blob_id);
-    if (blob_info || task->IsDirect()) {
+    if (HasBlob(tag_id, blob_name, blob_id) || task->IsDirect()) {
       return;
     }
     u32 name_hash = HashBlobName(tag_id, blob_name);
@@ -260,8 +693,7 @@ public:
     if constexpr (std::is_base_of_v<BlobWithName, TaskT>) {
       blob_name = task->blob_name_.str();
     }
-    BlobInfo *blob_info = GetBlobInfo(blob_name, blob_id);
-    if (blob_info || task->IsDirect()) {
+    if (HasBlob(tag_id, blob_name, blob_id) || task->IsDirect()) {
       return;
     }
     u32 name_hash = HashBlobName(tag_id, blob_name);
@@ -361,7 +793,7 @@ public:
   /** Get or create a tag */
   void GetOrCreateTag(GetOrCreateTagTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
+    chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
     TAG_ID_MAP_T &tag_id_map = tls.tag_id_map_;
     TAG_MAP_T &tag_map = tls.tag_map_;
     chi::string tag_name(task->tag_name_);
@@ -374,18 +806,19 @@ public:
     TagId tag_id;
     if (did_create) {
       TAG_MAP_T &tag_map = tls.tag_map_;
-      tag_id.unique_ = id_alloc_.fetch_add(1);
+      tag_id.unique_ = tag_id_alloc_.fetch_add(1);
       tag_id.hash_ = HashTagName(tag_name);
       tag_id.node_id_ = CHI_CLIENT->node_id_;
       HILOG(kInfo, "Creating tag for the first time: {} {}", tag_name.str(),
             tag_id);
       tag_id_map.emplace(tag_name, tag_id);
-      tag_map.emplace(tag_id, TagInfo());
-      TagInfo &tag = tag_map[tag_id];
+      bool did_emplace;
+      TagInfo &tag = tag_map.Emplace(tag_id, did_emplace);
       tag.name_ = tag_name;
       tag.tag_id_ = tag_id;
       tag.owner_ = task->blob_owner_;
       tag.internal_size_ = task->backend_size_;
+      SetPrefetchName(tls, tag_id, tag_name.str());
       if (task->flags_.Any(HERMES_SHOULD_STAGE)) {
         client_.RegisterStager(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
                                tag_id, chi::string(task->tag_name_.str()),
@@ -447,11 +880,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    task->tag_name_ = it->second.name_;
+    task->tag_name_ = tag_ptr->name_;
   }
   void MonitorGetTagName(MonitorModeId mode, GetTagNameTask *task,
                          RunContext &rctx) {
@@ -468,14 +901,27 @@ public:
   /** Destroy a tag */
   void DestroyTag(DestroyTagTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    FullPtr<GetTagNameTask> name_task;
+    _DestroyTag(task, tls, name_task);
+    // Wait for the prefetcher's name lookup only after the locks are gone
+    if (!name_task.IsNull()) {
+      name_task->Wait();
+      CHI_CLIENT->DelTask(HSHM_MCTX, name_task);
+    }
+  }
+
+  /** Remove a tag from the lane, handing back its pending name lookup */
+  void _DestroyTag(DestroyTagTask *task, HermesLane &tls,
+                   FullPtr<GetTagNameTask> &name_task) {
     chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     if (tag.owner_) {
+      tag.blobs_.splice(tag.blobs_.end(), tag.stale_blobs_);
       for (BlobId &blob_id : tag.blobs_) {
         client_.AsyncDestroyBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
                                  task->tag_id_, blob_id,
@@ -490,7 +936,16 @@ public:
     // Remove tag from maps
     TAG_ID_MAP_T &tag_id_map = tls.tag_id_map_;
     tag_id_map.erase(tag.name_);
-    tag_map.erase(it);
+    tls.tag_gen_map_.Erase(task->tag_id_);
+    {
+      chi::ScopedCoMutex prefetch_lock(tls.prefetch_lock_);
+      auto it = tls.prefetch_.find(task->tag_id_);
+      if (it != tls.prefetch_.end()) {
+        name_task = it->second.name_task_;
+        tls.prefetch_.erase(it);
+      }
+    }
+    tag_map.Erase(task->tag_id_);
   }
   void MonitorDestroyTag(MonitorModeId mode, DestroyTagTask *task,
                          RunContext &rctx) {
@@ -509,11 +964,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     tag.blobs_.emplace_back(task->blob_id_);
   }
   void MonitorTagAddBlob(MonitorModeId mode, TagAddBlobTask *task,
@@ -533,11 +988,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     auto blob_it =
         std::find(tag.blobs_.begin(), tag.blobs_.end(), task->blob_id_);
     tag.blobs_.erase(blob_it);
@@ -554,32 +1009,75 @@ public:
   CHI_END(TagRemoveBlob)
 
   CHI_BEGIN(TagClearBlobs)
-  /** Clear blobs from the tag */
+  /**
+   * Clear blobs from the tag. Bumping the generation hides the current
+   * blobs at once; they are destroyed lazily by ReclaimStaleBlobs.
+   * */
   void TagClearBlobs(TagClearBlobsTask *task, RunContext &rctx) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
-    TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    if (task->generation_ > 0) {
+      // Broadcast from the tag's owner: hide the blobs this node holds
+      RaiseTagGeneration(task->tag_id_, task->generation_);
       return;
     }
-    TagInfo &tag = it->second;
-    if (tag.owner_) {
-      for (BlobId &blob_id : tag.blobs_) {
-        client_.AsyncDestroyBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                                 task->tag_id_, blob_id,
-                                 DestroyBlobTask::kKeepInTag,
-                                 TASK_FIRE_AND_FORGET); // TODO(llogan): route
+    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    u64 generation;
+    {
+      chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
+      TAG_MAP_T &tag_map = tls.tag_map_;
+      TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+      if (tag_ptr == nullptr) {
+        return;
+      }
+      TagInfo &tag = *tag_ptr;
+      tag.generation_ += 1;
+      generation = tag.generation_;
+      RaiseTagGeneration(task->tag_id_, generation);
+      if (tag.owner_ && !tag.blobs_.empty()) {
+        if (tag.stale_blobs_.empty()) {
+          tls.stale_tags_.emplace_back(task->tag_id_);
+        }
+        tag.stale_blobs_.splice(tag.stale_blobs_.end(), tag.blobs_);
+      }
+      tag.blobs_.clear();
+      tag.internal_size_ = 0;
+    }
+    // The tag's blobs live on every node, so each must see the new generation
+    client_.TagClearBlobs(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                          task->tag_id_, generation);
+  }
+
+  /** Destroy a bounded number of the blobs hidden by TagClearBlobs */
+  void ReclaimStaleBlobs(HermesLane &tls) {
+    chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
+    size_t budget = kMaxReclaimPerFlush;
+    while (budget > 0 && !tls.stale_tags_.empty()) {
+      TagId tag_id = tls.stale_tags_.back();
+      TagInfo *tag_ptr = tls.tag_map_.Find(tag_id);
+      if (tag_ptr == nullptr) {
+        tls.stale_tags_.pop_back();
+        continue;
+      }
+      std::list<BlobId> &stale_blobs = tag_ptr->stale_blobs_;
+      for (; budget > 0 && !stale_blobs.empty(); --budget) {
+        client_.AsyncDestroyBlob(
+            HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), tag_id,
+            stale_blobs.front(),
+            DestroyBlobTask::kKeepInTag | DestroyBlobTask::kStaleOnly,
+            TASK_FIRE_AND_FORGET);
+        stale_blobs.pop_front();
+      }
+      if (stale_blobs.empty()) {
+        tls.stale_tags_.pop_back();
       }
     }
-    tag.blobs_.clear();
-    tag.internal_size_ = 0;
   }
   void MonitorTagClearBlobs(MonitorModeId mode, TagClearBlobsTask *task,
                             RunContext &rctx) {
     switch (mode) {
     case MonitorMode::kSchedule: {
-      TagCacheWriteRoute<TagClearBlobsTask>(task);
+      if (task->generation_ == 0) {
+        TagCacheWriteRoute<TagClearBlobsTask>(task);
+      }
       return;
     }
     }
@@ -592,12 +1090,12 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       task->size_ = 0;
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     task->size_ = tag.internal_size_;
   }
   void MonitorTagGetSize(MonitorModeId mode, TagGetSizeTask *task,
@@ -615,9 +1113,10 @@ public:
   /** Update the size of a tag */
   void TagUpdateSize(TagUpdateSizeTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
+    chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    TagInfo &tag = tag_map[task->tag_id_];
+    bool did_create;
+    TagInfo &tag = tag_map.Emplace(task->tag_id_, did_create);
     ssize_t internal_size = (ssize_t)tag.internal_size_;
     if (task->mode_ == UpdateSizeMode::kAdd) {
       internal_size += task->update_;
@@ -648,11 +1147,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     chi::ipc::vector<BlobId> &blobs = task->blob_ids_;
     blobs.reserve(tag.blobs_.size());
     for (BlobId &blob_id : tag.blobs_) {
@@ -677,11 +1176,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
     TAG_MAP_T &tag_map = tls.tag_map_;
-    auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = it->second;
+    TagInfo &tag = *tag_ptr;
     for (BlobId &blob_id : tag.blobs_) {
       client_.FlushBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
                         blob_id); // TODO(llogan): route
@@ -692,51 +1191,401 @@ public:
                        RunContext &rctx) {}
   CHI_END(TagUpdateSize)
 
+  CHI_BEGIN(TagTruncate)
+  /**
+   * Truncate the pages of a tag. Whole pages past the new size are
+   * destroyed and the last page is trimmed. The backend of staged tags is
+   * truncated only once those finish. Otherwise, a flush of a dropped page
+   * could regrow the file.
+   * */
+  void TagTruncate(TagTruncateTask *task, RunContext &rctx) {
+    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    std::vector<FullPtr<DestroyBlobTask>> destroy_tasks;
+    std::vector<FullPtr<TruncateBlobTask>> trunc_tasks;
+    std::vector<BlobId> named_ids;
+    size_t page_size = task->page_size_ > 0 ? task->page_size_ : MEGABYTES(1);
+    size_t num_pages = (task->size_ + page_size - 1) / page_size;
+    size_t last_page_size = task->size_ % page_size;
+    bool owner = false;
+    // Destroy or trim \a page. Returns true if it leaves the tag.
+    auto truncate_page = [&](const BlobId &blob_id, size_t page) {
+      if (page >= num_pages) {
+        if (owner) {
+          destroy_tasks.emplace_back(client_.AsyncDestroyBlob(
+              HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), task->tag_id_,
+              blob_id, DestroyBlobTask::kKeepInTag));
+        }
+        return true;
+      }
+      if (last_page_size > 0 && page + 1 == num_pages) {
+        trunc_tasks.emplace_back(client_.AsyncTruncateBlob(
+            HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), task->tag_id_,
+            blob_id, last_page_size, TruncateBlobTask::kKeepTagSize));
+      }
+      return false;
+    };
+    {
+      chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
+      TAG_MAP_T &tag_map = tls.tag_map_;
+      TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+      if (tag_ptr == nullptr) {
+        return;
+      }
+      TagInfo &tag = *tag_ptr;
+      owner = tag.owner_;
+      size_t old_pages = (tag.internal_size_ + page_size - 1) / page_size;
+      bool has_named_pages =
+          old_pages > 0 && !HasPageBlobId(task->tag_id_, old_pages - 1);
+      // Pages created by name have page IDs too (see FindPageBlobId)
+      tag.blobs_.remove_if([&](const BlobId &blob_id) {
+        if (IsPageBlobId(blob_id)) {
+          return truncate_page(blob_id, GetPageIndex(blob_id));
+        }
+        if (has_named_pages) {
+          named_ids.emplace_back(blob_id);
+        }
+        return false;
+      });
+      tag.internal_size_ = task->size_;
+    }
+    // Pages past the range of page IDs are known only by their names
+    if (!named_ids.empty()) {
+      std::vector<FullPtr<GetBlobNameTask>> name_tasks;
+      name_tasks.reserve(named_ids.size());
+      for (BlobId &blob_id : named_ids) {
+        name_tasks.emplace_back(client_.AsyncGetBlobName(
+            HSHM_MCTX, chi::DomainQuery::GetDynamic(), task->tag_id_,
+            blob_id));
+      }
+      task->Wait(name_tasks);
+      std::unordered_set<BlobId> dropped;
+      for (size_t i = 0; i < named_ids.size(); ++i) {
+        size_t page;
+        if (ParsePageBlobName(name_tasks[i]->blob_name_.str(), page) &&
+            truncate_page(named_ids[i], page)) {
+          dropped.emplace(named_ids[i]);
+        }
+        CHI_CLIENT->DelTask(HSHM_MCTX, name_tasks[i]);
+      }
+      chi::ScopedCoRwWriteLock tag_map_lock(tls.tag_map_lock_);
+      TagInfo *tag_ptr = tls.tag_map_.Find(task->tag_id_);
+      if (tag_ptr != nullptr && !dropped.empty()) {
+        tag_ptr->blobs_.remove_if([&](const BlobId &blob_id) {
+          return dropped.find(blob_id) != dropped.end();
+        });
+      }
+    }
+    // Wait for the dropped pages without holding the tag map lock
+    task->Wait(destroy_tasks);
+    task->Wait(trunc_tasks);
+    for (FullPtr<DestroyBlobTask> &destroy_task : destroy_tasks) {
+      CHI_CLIENT->DelTask(HSHM_MCTX, destroy_task);
+    }
+    for (FullPtr<TruncateBlobTask> &trunc_task : trunc_tasks) {
+      CHI_CLIENT->DelTask(HSHM_MCTX, trunc_task);
+    }
+    // Truncate the backend of staged tags
+    HermesLane &tag_tls = GetLaneTls(task->tag_id_.hash_);
+    chi::ScopedCoMutex stager_map_lock(tag_tls.stager_map_lock_);
+    auto it = tag_tls.stager_map_.find(task->tag_id_);
+    if (it != tag_tls.stager_map_.end()) {
+      it->second->Truncate(HSHM_MCTX, client_, task->tag_id_, task->size_);
+    }
+  }
+  void MonitorTagTruncate(MonitorModeId mode, TagTruncateTask *task,
+                          RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kSchedule: {
+      TagCacheWriteRoute<TagTruncateTask>(task);
+      return;
+    }
+    }
+  }
+  CHI_END(TagTruncate)
+
   /**
    * ========================================
    * BLOB Methods
    * ========================================
    * */
 
-  /** Get or create a blob ID */
+  /** The current generation of a tag. Lock-free. */
+  u64 GetTagGeneration(const TagId &tag_id) {
+    u64 generation = 0;
+    GetLaneTls(tag_id.hash_).tag_gen_map_.Find(tag_id, generation);
+    return generation;
+  }
+
+  /** Raise the generation of a tag, never lowering it. Lock-free. */
+  void RaiseTagGeneration(const TagId &tag_id, u64 generation) {
+    TAG_GEN_MAP_T &tag_gen_map = GetLaneTls(tag_id.hash_).tag_gen_map_;
+    u64 cur_generation = 0;
+    if (tag_gen_map.Find(tag_id, cur_generation) &&
+        cur_generation >= generation) {
+      return;
+    }
+    if (!tag_gen_map.Update(tag_id, generation)) {
+      tag_gen_map.Emplace(tag_id, generation);
+    }
+  }
+
+  /** Whether a blob was written before its tag was last cleared */
+  bool IsStaleBlob(const BlobInfo &blob_info) {
+    return blob_info.tag_gen_ < GetTagGeneration(blob_info.tag_id_);
+  }
+
+  /** Queue a modified blob for the flusher if it is backed by a stager */
+  void MarkDirty(HermesLane &tls, BlobInfo &blob_info) {
+    if (!blob_info.flags_.Any(HERMES_SHOULD_STAGE)) {
+      return;
+    }
+    chi::ScopedCoMutex dirty_lock(tls.dirty_lock_);
+    tls.dirty_blobs_.emplace(blob_info.blob_id_);
+  }
+
+  /**
+   * Join the stage-in of a blob already in flight, or with \a start, stage
+   * in the parts of the blob's page that no put has written. Nothing is
+   * read if \a need is already valid or the whole page has been written.
+   * Returns true if the caller must wait with WaitStageIn.
+   * */
+  bool BeginStageIn(HermesLane &tls, BlobInfo &blob_info, const Extent &need,
+                    float score, bool start) {
+    if (!blob_info.flags_.Any(HERMES_SHOULD_STAGE)) {
+      return false;
+    }
+    chi::ScopedCoMutex stage_in_lock(tls.stage_in_lock_);
+    auto it = tls.stage_ins_.find(blob_info.blob_id_);
+    if (it != tls.stage_ins_.end()) {
+      ++it->second.waiters_;
+      return true;
+    }
+    if (!start || blob_info.flags_.Any(HERMES_DID_STAGE_IN)) {
+      return false;
+    }
+    std::shared_ptr<AbstractStager> stager = GetStager(blob_info.tag_id_);
+    size_t page_size = stager ? stager->GetPageSize() : 0;
+    std::vector<Extent> gaps;
+    {
+      // flags_ is shared with the blob's other writers, so set it locked
+      chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
+      if (need.size_ > 0 && blob_info.valid_.Contains(need.off_, need.size_)) {
+        return false;
+      }
+      if (page_size > 0) {
+        blob_info.valid_.GetGaps(0, page_size, gaps);
+      } else {
+        gaps.emplace_back(Extent{0, 0});
+      }
+      blob_info.flags_.SetBits(HERMES_DID_STAGE_IN);
+    }
+    if (gaps.empty()) {
+      return false;
+    }
+    StageInWait &wait = tls.stage_ins_[blob_info.blob_id_];
+    wait.waiters_ = 1;
+    for (const Extent &gap : gaps) {
+      wait.tasks_.emplace_back(client_.AsyncStageIn(
+          HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), blob_info.tag_id_,
+          blob_info.name_, gap.off_, gap.size_, score));
+    }
+    return true;
+  }
+
+  /**
+   * Wait for a stage-in started or joined by BeginStageIn. The caller must
+   * not hold the lane's locks, since the staged data is put into the blob
+   * by a separate task. The last waiter frees the stage-in tasks.
+   * */
+  void WaitStageIn(HermesLane &tls, const BlobId &blob_id) {
+    std::vector<FullPtr<StageInTask>> tasks;
+    {
+      chi::ScopedCoMutex stage_in_lock(tls.stage_in_lock_);
+      tasks = tls.stage_ins_[blob_id].tasks_;
+    }
+    for (FullPtr<StageInTask> &stage_task : tasks) {
+      stage_task->Wait();
+    }
+    chi::ScopedCoMutex stage_in_lock(tls.stage_in_lock_);
+    auto it = tls.stage_ins_.find(blob_id);
+    if (--it->second.waiters_ == 0) {
+      for (FullPtr<StageInTask> &stage_task : it->second.tasks_) {
+        CHI_CLIENT->DelTask(HSHM_MCTX, stage_task);
+      }
+      tls.stage_ins_.erase(it);
+    }
+  }
+
+  /**
+   * Resolve the blob of a put or get. Gets stage in the blob if the bytes
+   * they read were never written; puts only wait for a stage-in already
+   * in flight, since the bytes they write need no read. The wait happens
+   * without holding the lane's locks, so the lane keeps serving other
+   * blobs. Puts made by the stagers themselves skip this, since a
+   * stage-in waits on its own put. A put may pass this check and apply
+   * after a get computed its gaps; PutBlob then keeps the put's bytes
+   * over the staged-in ones.
+   * */
+  template <typename TaskT>
+  void StageInBlob(TaskT *task, HermesLane &tls, bool is_get) {
+    GetOrCreateBlob(tls, task->tag_id_, task->blob_id_,
+                    chi::string(task->blob_name_), task->flags_);
+    {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      if (task->data_size_ == 0 || task->flags_.Any(HERMES_IS_STAGE_IN)) {
+        return;
+      }
+      BlobInfo *blob_ptr = tls.blob_map_.Find(task->blob_id_);
+      if (blob_ptr == nullptr) {
+        return;
+      }
+      BlobInfo &blob_info = *blob_ptr;
+      if (is_get) {
+        // Prefetching starts first so it overlaps the stage-in
+        PrefetchPages(tls, task->tag_id_, task->blob_id_,
+                      blob_info.flags_.Any(HERMES_SHOULD_STAGE),
+                      blob_info.flags_.Any(HERMES_DID_STAGE_IN),
+                      blob_info.score_);
+      }
+      Extent need{task->blob_off_, task->data_size_};
+      if (!BeginStageIn(tls, blob_info, need, 1, is_get)) {
+        return;
+      }
+    }
+    WaitStageIn(tls, task->blob_id_);
+  }
+
+  /** Reset a stale blob so it can be reused in the current generation */
+  void RenewStaleBlob(HermesLane &tls, BlobInfo &blob_info,
+                      bitfield32_t &flags) {
+    u64 generation = GetTagGeneration(blob_info.tag_id_);
+    if (blob_info.tag_gen_ >= generation) {
+      return;
+    }
+    chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
+    FreeBuffers(tls, blob_info.buffers_);
+    blob_info.ClearBuffers();
+    blob_info.blob_size_ = 0;
+    blob_info.max_blob_size_ = 0;
+    blob_info.mod_count_ = 0;
+    blob_info.last_flush_ = 0;
+    blob_info.tag_gen_ = generation;
+    blob_info.valid_.Clear();
+    blob_info.dirty_.Clear();
+    flags.SetBits(HERMES_BLOB_DID_CREATE);
+    blob_info.flags_ = flags;
+  }
+
+  /**
+   * Get or create the blob named by \a blob_id, or by \a blob_name if the
+   * ID is null. Existing blobs are found under the lane's read lock. New
+   * blobs are created under its write lock, since the blob indices take
+   * one writer at a time. Call without holding the blob map lock.
+   * */
+  void GetOrCreateBlob(HermesLane &tls, TagId &tag_id, BlobId &blob_id,
+                       const chi::string &blob_name, bitfield32_t &flags) {
+    if (blob_id.IsNull()) {
+      blob_id = FindPageBlobId(tag_id, blob_name);
+    }
+    {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      if (FindBlob(tls, tag_id, blob_id, blob_name, flags)) {
+        return;
+      }
+    }
+    chi::ScopedCoRwWriteLock blob_map_lock(tls.blob_map_lock_);
+    if (blob_id.IsNull()) {
+      blob_id = GetOrCreateBlobId(tls, tag_id, HashBlobName(tag_id, blob_name),
+                                  blob_name, flags);
+    } else {
+      GetOrCreatePageBlob(tls, tag_id, blob_id, flags);
+    }
+  }
+
+  /**
+   * Find the blob named by \a blob_id or \a blob_name and renew it if it
+   * is stale. False if the blob must be created.
+   * */
+  bool FindBlob(HermesLane &tls, const TagId &tag_id, BlobId &blob_id,
+                const chi::string &blob_name, bitfield32_t &flags) {
+    if (blob_id.IsNull()) {
+      blob_id = FindBlobId(tls, tag_id, blob_name);
+      if (blob_id.IsNull()) {
+        return false;
+      }
+    } else if (!IsPageBlobId(blob_id)) {
+      return true;
+    }
+    BlobInfo *blob_info = tls.blob_map_.Find(blob_id);
+    if (blob_info == nullptr) {
+      return false;
+    }
+    RenewStaleBlob(tls, *blob_info, flags);
+    return true;
+  }
+
+  /** Get or create a blob ID (blob map write lock held) */
   BlobId GetOrCreateBlobId(HermesLane &tls, TagId &tag_id, u32 name_hash,
                            const chi::string &blob_name, bitfield32_t &flags) {
-    chi::string blob_name_unique = GetBlobNameWithBucket(tag_id, blob_name);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    auto it = blob_id_map.find(blob_name_unique);
-    if (it == blob_id_map.end()) {
-      BlobId blob_id =
-          BlobId(CHI_CLIENT->node_id_, name_hash, id_alloc_.fetch_add(1));
-      blob_id_map.emplace(blob_name_unique, blob_id);
-      flags.SetBits(HERMES_BLOB_DID_CREATE);
-      BLOB_MAP_T &blob_map = tls.blob_map_;
-      blob_map.emplace(blob_id, BlobInfo());
-      BlobInfo &blob_info = blob_map[blob_id];
-      blob_info.name_ = blob_name;
-      blob_info.blob_id_ = blob_id;
-      blob_info.tag_id_ = tag_id;
-      blob_info.blob_size_ = 0;
-      blob_info.max_blob_size_ = 0;
-      blob_info.score_ = 1;
-      blob_info.mod_count_ = 0;
-      blob_info.access_freq_ = 0;
-      blob_info.last_flush_ = 0;
-      blob_info.flags_ = flags;
-      return blob_id;
+    BlobId blob_id = FindBlobId(tls, tag_id, blob_name);
+    if (blob_id.IsNull()) {
+      blob_id = BlobId(CHI_CLIENT->node_id_, name_hash, id_alloc_.fetch_add(1));
+      CreateBlob(tls, tag_id, blob_id, blob_name, flags);
+    } else {
+      RenewStaleBlob(tls, *tls.blob_map_.Find(blob_id), flags);
     }
-    return it->second;
+    return blob_id;
+  }
+
+  /**
+   * Create the page blob \a blob_id of a paged tag if it does not exist
+   * (blob map write lock held)
+   * */
+  void GetOrCreatePageBlob(HermesLane &tls, const TagId &tag_id,
+                           const BlobId &blob_id, bitfield32_t &flags) {
+    if (!IsPageBlobId(blob_id)) {
+      return;
+    }
+    BlobInfo *blob_info = tls.blob_map_.Find(blob_id);
+    if (blob_info) {
+      RenewStaleBlob(tls, *blob_info, flags);
+      return;
+    }
+    CreateBlob(tls, tag_id, blob_id, GetPageBlobName(GetPageIndex(blob_id)),
+               flags);
+  }
+
+  /** Create the metadata of a new blob */
+  void CreateBlob(HermesLane &tls, const TagId &tag_id, const BlobId &blob_id,
+                  const chi::string &blob_name, bitfield32_t &flags) {
+    flags.SetBits(HERMES_BLOB_DID_CREATE);
+    BLOB_MAP_T &blob_map = tls.blob_map_;
+    bool did_emplace;
+    BlobInfo &blob_info = blob_map.Emplace(blob_id, did_emplace);
+    blob_info.name_ = blob_name;
+    blob_info.blob_id_ = blob_id;
+    blob_info.tag_id_ = tag_id;
+    blob_info.blob_size_ = 0;
+    blob_info.max_blob_size_ = 0;
+    blob_info.score_ = 1;
+    blob_info.mod_count_ = 0;
+    blob_info.access_freq_ = 0;
+    blob_info.last_flush_ = 0;
+    blob_info.tag_gen_ = GetTagGeneration(tag_id);
+    blob_info.valid_.Clear();
+    blob_info.dirty_.Clear();
+    blob_info.flags_ = flags;
+    AddBlobId(tls, blob_info);
   }
 
   CHI_BEGIN(GetOrCreateBlobId)
   /** Get or create a blob ID */
   void GetOrCreateBlobId(GetOrCreateBlobIdTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    chi::string blob_name(task->blob_name_);
     bitfield32_t flags;
-    task->blob_id_ = GetOrCreateBlobId(tls, task->tag_id_,
-                                       HashBlobName(task->tag_id_, blob_name),
-                                       blob_name, flags);
+    task->blob_id_ = BlobId::GetNull();
+    GetOrCreateBlob(tls, task->tag_id_, task->blob_id_,
+                    chi::string(task->blob_name_), flags);
   }
   void MonitorGetOrCreateBlobId(MonitorModeId mode, GetOrCreateBlobIdTask *task,
                                 RunContext &rctx) {
@@ -754,18 +1603,15 @@ public:
   void GetBlobId(GetBlobIdTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    chi::string blob_name(task->blob_name_);
-    chi::string blob_name_unique =
-        GetBlobNameWithBucket(task->tag_id_, blob_name);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    auto it = blob_id_map.find(blob_name_unique);
-    if (it == blob_id_map.end()) {
+    task->blob_id_ = FindBlobId(tls, task->tag_id_, task->blob_name_);
+    if (!task->blob_id_.IsNull() &&
+        IsStaleBlob(*tls.blob_map_.Find(task->blob_id_))) {
       task->blob_id_ = BlobId::GetNull();
-      HILOG(kDebug, "Failed to find blob {} in {}", blob_name.str(),
+    }
+    if (task->blob_id_.IsNull()) {
+      HILOG(kDebug, "Failed to find blob {} in {}", task->blob_name_.str(),
             task->tag_id_);
-      return;
     }
-    task->blob_id_ = it->second;
   }
   void MonitorGetBlobId(MonitorModeId mode, GetBlobIdTask *task,
                         RunContext &rctx) {
@@ -784,11 +1630,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
+    BlobInfo &blob = *blob_ptr;
     task->blob_name_ = blob.name_;
   }
   void MonitorGetBlobName(MonitorModeId mode, GetBlobNameTask *task,
@@ -802,48 +1648,280 @@ public:
   }
   CHI_END(GetBlobName)
 
-  CHI_BEGIN(GetBlobSize)
-  /** Get the blob size */
-  void GetBlobSize(GetBlobSizeTask *task, RunContext &rctx) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    if (task->blob_id_.IsNull()) {
-      bitfield32_t flags;
-      task->blob_id_ = GetOrCreateBlobId(
-          tls, task->tag_id_, HashBlobName(task->tag_id_, task->blob_name_),
-          chi::string(task->blob_name_), flags);
-    }
-    BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
-      task->size_ = 0;
-      return;
-    }
-    BlobInfo &blob = it->second;
-    task->size_ = blob.blob_size_;
-  }
-  void MonitorGetBlobSize(MonitorModeId mode, GetBlobSizeTask *task,
-                          RunContext &rctx) {
-    switch (mode) {
-    case MonitorMode::kSchedule: {
-      BlobCacheReadRoute<GetBlobSizeTask>(task);
+  CHI_BEGIN(PrefetchBlob)
+  /**
+   * The ID of the bucket named \a name, cached for apriori rules in the
+   * lane the name hashes to. The lookup runs in the background, so the
+   * ID is null until it completes.
+   * */
+  TagId GetAprioriTag(const std::string &name) {
+    HermesLane &tls = GetLaneTls(HashTagName(name));
+    chi::ScopedCoMutex prefetch_lock(tls.prefetch_lock_);
+    AprioriTag &tag = tls.apriori_tags_[name];
+    if (!tag.task_.IsNull() && tag.task_->IsComplete()) {
+      tag.tag_id_ = tag.task_->tag_id_;
+      CHI_CLIENT->DelTask(HSHM_MCTX, tag.task_);
+      tag.task_ = FullPtr<GetTagIdTask>();
+    }
+    if (tag.tag_id_.IsNull() && tag.task_.IsNull()) {
+      tag.task_ = client_.AsyncGetTagId(
+          HSHM_MCTX, chi::DomainQuery::GetDynamic(), chi::string(name));
+    }
+    return tag.tag_id_;
+  }
+
+  /** Record the name of a tag created in lane \a tls for the prefetchers */
+  void SetPrefetchName(HermesLane &tls, const TagId &tag_id,
+                       const std::string &name) {
+    config::PrefetchInfo &prefetch = HERMES_SERVER_CONF.prefetcher_;
+    if (!prefetch.enabled_ && !trace_.is_open()) {
       return;
     }
+    chi::ScopedCoMutex prefetch_lock(tls.prefetch_lock_);
+    auto it = tls.prefetch_.find(tag_id);
+    if (it == tls.prefetch_.end()) {
+      it = tls.prefetch_
+               .emplace(tag_id,
+                        TagPrefetch{ReadAhead(prefetch.read_ahead_max_)})
+               .first;
     }
+    it->second.name_ = name;
   }
-  CHI_END(GetBlobSize)
 
-  CHI_BEGIN(GetBlobScore)
+  /**
+   * The name of the tag of \a state, or empty while it is being looked up.
+   * The lookup is started here if the tag was created on another node.
+   * */
+  const std::string &GetPrefetchName(const TagId &tag_id,
+                                     TagPrefetch &state) {
+    if (!state.name_.empty()) {
+      return state.name_;
+    }
+    if (state.name_task_.IsNull()) {
+      state.name_task_ = client_.AsyncGetTagName(
+          HSHM_MCTX, chi::DomainQuery::GetDynamic(), tag_id);
+    } else if (state.name_task_->IsComplete()) {
+      state.name_ = state.name_task_->tag_name_.str();
+      CHI_CLIENT->DelTask(HSHM_MCTX, state.name_task_);
+      state.name_task_ = FullPtr<GetTagNameTask>();
+      if (state.name_.empty()) {
+        // The tag is gone. Trace its reads by ID rather than retrying.
+        state.name_ = hshm::Formatter::format("{}", tag_id);
+      }
+    }
+    return state.name_;
+  }
+
+  /**
+   * Append page reads to the lane's trace buffer. Reads never touch the
+   * trace file: the buffer is written by FlushData, and records arriving
+   * while it is full are dropped and counted.
+   * */
+  void TracePages(HermesLane &tls, const std::vector<size_t> &pages,
+                  const std::string &name) {
+    chi::ScopedCoMutex trace_lock(tls.trace_lock_);
+    for (size_t page : pages) {
+      if (tls.trace_buf_.size() >= kTraceBufSize) {
+        tls.trace_dropped_ += 1;
+        continue;
+      }
+      tls.trace_buf_ += hshm::Formatter::format(
+          "{} {} {}\n", CHI_CLIENT->node_id_, page, name);
+    }
+  }
+
+  /** Write out the trace records buffered by a lane */
+  void FlushTrace(HermesLane &tls) {
+    if (!trace_.is_open()) {
+      return;
+    }
+    std::string records;
+    size_t dropped;
+    {
+      chi::ScopedCoMutex trace_lock(tls.trace_lock_);
+      records.swap(tls.trace_buf_);
+      dropped = tls.trace_dropped_;
+      tls.trace_dropped_ = 0;
+    }
+    if (dropped > 0) {
+      HELOG(kWarning, "The I/O trace dropped {} page reads", dropped);
+    }
+    if (records.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> trace_lock(trace_lock_);
+    trace_.write(records.data(), records.size());
+  }
+
+  /**
+   * Handle a page read for the prefetchers. The read is recorded in the
+   * I/O trace and fed to the tag's read-ahead detector; the pages it
+   * predicts and the pages named by matching apriori rules are then
+   * staged in (or promoted) in the background. \a hit tells whether a
+   * staged page was already staged in. Nothing here waits on another
+   * task, since it runs under the blob map lock of \a tls.
+   * */
+  void PrefetchPages(HermesLane &tls, const TagId &tag_id,
+                     const BlobId &blob_id, bool staged, bool hit,
+                     float score) {
+    config::PrefetchInfo &prefetch = HERMES_SERVER_CONF.prefetcher_;
+    if (!IsPageBlobId(blob_id) || (!prefetch.enabled_ && !trace_.is_open())) {
+      return;
+    }
+    size_t page = GetPageIndex(blob_id);
+    std::vector<size_t> pages;
+    std::vector<size_t> traced;
+    std::string name;
+    {
+      // Prefetcher state lives in the lane owning the tag
+      HermesLane &tag_tls = GetLaneTls(tag_id.hash_);
+      chi::ScopedCoMutex prefetch_lock(tag_tls.prefetch_lock_);
+      auto it = tag_tls.prefetch_.find(tag_id);
+      if (it == tag_tls.prefetch_.end()) {
+        it = tag_tls.prefetch_
+                 .emplace(tag_id,
+                          TagPrefetch{ReadAhead(prefetch.read_ahead_max_)})
+                 .first;
+      }
+      TagPrefetch &state = it->second;
+      if (prefetch.enabled_ && staged) {
+        state.read_ahead_.Observe(page, hit, pages);
+      }
+      name = GetPrefetchName(tag_id, state);
+      if (trace_.is_open()) {
+        // Reads are traced by name, so hold them until the name is known
+        state.untraced_.emplace_back(page);
+        if (!name.empty()) {
+          traced.swap(state.untraced_);
+        }
+      }
+    }
+    if (!traced.empty()) {
+      TracePages(tls, traced, name);
+    }
+    for (size_t next : pages) {
+      if (!HasPageBlobId(tag_id, next)) {
+        continue;
+      }
+      client_.AsyncPrefetchBlob(HSHM_MCTX, chi::DomainQuery::GetDynamic(),
+                                tag_id, GetPageBlobId(tag_id, next), score,
+                                TASK_FIRE_AND_FORGET); // OK
+    }
+    if (!prefetch.enabled_ || !apriori_.HasBucket(name)) {
+      return;
+    }
+    std::vector<const AprioriRule *> rules;
+    apriori_.Find(name, page, rules);
+    for (const AprioriRule *rule : rules) {
+      for (const AprioriPrefetch &target : rule->prefetch_) {
+        TagId target_id = GetAprioriTag(target.pages_.bkt_name_);
+        if (target_id.IsNull()) {
+          continue;
+        }
+        for (size_t p = target.pages_.begin_;
+             p <= target.pages_.end_ && HasPageBlobId(target_id, p); ++p) {
+          client_.AsyncPrefetchBlob(HSHM_MCTX, chi::DomainQuery::GetDynamic(),
+                                    target_id, GetPageBlobId(target_id, p),
+                                    target.score_,
+                                    TASK_FIRE_AND_FORGET); // OK
+        }
+      }
+    }
+  }
+
+  /**
+   * Stage in a page blob ahead of its reader. Blobs already staged in are
+   * promoted to the prefetch score instead.
+   * */
+  void PrefetchBlob(PrefetchBlobTask *task, RunContext &rctx) {
+    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    if (tls.blob_map_.Find(task->blob_id_) == nullptr) {
+      // Only pages of staged tags can be created ahead of time
+      if (GetStager(task->tag_id_) == nullptr) {
+        return;
+      }
+      bitfield32_t flags;
+      flags.SetBits(HERMES_SHOULD_STAGE);
+      chi::ScopedCoRwWriteLock blob_map_lock(tls.blob_map_lock_);
+      GetOrCreatePageBlob(tls, task->tag_id_, task->blob_id_, flags);
+    }
+    {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      BlobInfo *blob_ptr = tls.blob_map_.Find(task->blob_id_);
+      if (blob_ptr == nullptr) {
+        return;
+      }
+      BlobInfo &blob_info = *blob_ptr;
+      if (!blob_info.flags_.Any(HERMES_SHOULD_STAGE) ||
+          blob_info.flags_.Any(HERMES_DID_STAGE_IN)) {
+        if (task->score_ > blob_info.score_ &&
+            !blob_info.flags_.Any(HERMES_USER_SCORE_STATIONARY)) {
+          client_.AsyncReorganizeBlob(
+              HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), task->tag_id_,
+              chi::string(""), task->blob_id_, task->score_, false,
+              Context(), TASK_FIRE_AND_FORGET); // OK
+        }
+        return;
+      }
+      // Readers arriving meanwhile wait on this stage-in
+      if (!BeginStageIn(tls, blob_info, Extent(), task->score_, true)) {
+        return;
+      }
+    }
+    WaitStageIn(tls, task->blob_id_);
+  }
+  void MonitorPrefetchBlob(MonitorModeId mode, PrefetchBlobTask *task,
+                           RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kSchedule: {
+      BlobCacheWriteRoute<PrefetchBlobTask>(task);
+      return;
+    }
+    }
+  }
+  CHI_END(PrefetchBlob)
+
+  CHI_BEGIN(GetBlobSize)
+  /** Get the blob size */
+  void GetBlobSize(GetBlobSizeTask *task, RunContext &rctx) {
+    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    if (task->blob_id_.IsNull()) {
+      bitfield32_t flags;
+      GetOrCreateBlob(tls, task->tag_id_, task->blob_id_,
+                      chi::string(task->blob_name_), flags);
+    }
+    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+    BLOB_MAP_T &blob_map = tls.blob_map_;
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
+      task->size_ = 0;
+      return;
+    }
+    BlobInfo &blob = *blob_ptr;
+    task->size_ = blob.blob_size_;
+  }
+  void MonitorGetBlobSize(MonitorModeId mode, GetBlobSizeTask *task,
+                          RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kSchedule: {
+      BlobCacheReadRoute<GetBlobSizeTask>(task);
+      return;
+    }
+    }
+  }
+  CHI_END(GetBlobSize)
+
+  CHI_BEGIN(GetBlobScore)
   /** Get the score of a blob */
   void GetBlobScore(GetBlobScoreTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
+    BlobInfo &blob = *blob_ptr;
     task->score_ = blob.score_;
   }
   void MonitorGetBlobScore(MonitorModeId mode, GetBlobScoreTask *task,
@@ -863,11 +1941,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
+    BlobInfo &blob = *blob_ptr;
     task->buffers_ = blob.buffers_;
   }
   void MonitorGetBlobBuffers(MonitorModeId mode, GetBlobBuffersTask *task,
@@ -881,6 +1959,87 @@ public:
   }
   CHI_END(GetBlobBuffers)
 
+  /**
+   * Allocate \a size bytes of \a target from the lane's block cache.
+   * The cache is refilled from the bdev in one batch when it runs dry.
+   * May return fewer bytes if the target is full, in which case the other
+   * lanes are asked to give back their idle blocks.
+   * */
+  std::vector<chi::Block> AllocateBuffers(HermesLane &tls, TargetInfo &target,
+                                          size_t size) {
+    BufferCache &cache = GetBufferCache(tls, target);
+    std::vector<chi::Block> blocks;
+    size_t taken = cache.Take(size, blocks);
+    target.UpdateCached(-(ssize_t)taken);
+    if (taken >= size) {
+      return blocks;
+    }
+    std::vector<chi::Block> refill = target.client_.Allocate(
+        HSHM_MCTX, target.dom_query_, size - taken + cache.GetRefillSize());
+    size_t reserved = 0;
+    for (chi::Block &block : refill) {
+      cache.Put(block);
+      reserved += block.size_;
+    }
+    target.ConsumeCap(reserved);
+    size_t more = cache.Take(size - taken, blocks);
+    target.UpdateCached((ssize_t)reserved - (ssize_t)more);
+    if (taken + more < size && target.GetCached() > 0) {
+      target.RequestDrain();
+    }
+    return blocks;
+  }
+
+  /**
+   * Return buffers to the lane's block caches. Caches holding too many idle
+   * bytes are drained back to their bdev in one batch.
+   * */
+  void FreeBuffers(HermesLane &tls, const std::vector<BufferInfo> &buffers) {
+    for (const BufferInfo &buf : buffers) {
+      TargetInfo &target = *target_map_[buf.tid_];
+      GetBufferCache(tls, target).Put(buf);
+      target.UpdateCached((ssize_t)buf.size_);
+    }
+    for (const BufferInfo &buf : buffers) {
+      TargetInfo &target = *target_map_[buf.tid_];
+      BufferCache &cache = tls.buffer_caches_[buf.tid_];
+      if (cache.NeedsDrain()) {
+        DrainCache(target, cache, cache.GetRefillSize());
+      }
+    }
+  }
+
+  /** The lane's cache of \a target, emptied first if a drain was requested */
+  BufferCache &GetBufferCache(HermesLane &tls, TargetInfo &target) {
+    BufferCache &cache = tls.buffer_caches_[target.id_];
+    size_t epoch = target.GetDrainEpoch();
+    if (cache.drain_epoch_ != epoch) {
+      cache.drain_epoch_ = epoch;
+      DrainCache(target, cache, 0);
+    }
+    return cache;
+  }
+
+  /** Give the idle blocks of a cache beyond \a keep bytes back to the bdev */
+  void DrainCache(TargetInfo &target, BufferCache &cache, size_t keep) {
+    std::vector<chi::Block> drained;
+    cache.Drain(keep, drained);
+    size_t released = 0;
+    for (chi::Block &block : drained) {
+      target.client_.Free(HSHM_MCTX, target.dom_query_, block);
+      released += block.size_;
+    }
+    target.UpdateCached(-(ssize_t)released);
+    target.ReleaseCap(released);
+  }
+
+  /** Honor the drain requests of all targets, even on an idle lane */
+  void DrainRequestedCaches(HermesLane &tls) {
+    for (TargetInfo &target : targets_) {
+      GetBufferCache(tls, target);
+    }
+  }
+
   /** A slice of data in a bigger data element */
   struct Slice {
     size_t off_ = 0;
@@ -899,7 +2058,8 @@ public:
     size_t cutoff_;      // max value of cur_off
 
   public:
-    DataIterator(const Slice &part) : part_(part), rem_(part) {
+    DataIterator(const Slice &part, size_t cur_off = 0)
+        : part_(part), rem_(part), cur_off_(cur_off) {
       cutoff_ = part_.off_ + part_.size_;
     }
 
@@ -927,18 +2087,85 @@ public:
     bool IsDone() { return cur_off_ >= cutoff_ || rem_.size_ == 0; }
   };
 
+  /** A contiguous extent of a target to read or write */
+  struct BdevSegment {
+    TargetId tid_;    // target holding the extent
+    size_t tgt_off_;  // offset in the target
+    size_t data_off_; // offset in the I/O buffer
+    size_t size_;     // size of the extent
+  };
+
+  /**
+   * Find the target extents backing \a part of a blob. Buffers which sit
+   * back to back on the same target are merged into a single extent, so
+   * they cost one bdev request instead of one per buffer.
+   * */
+  void GetBdevSegments(BlobInfo &blob_info, const Slice &part,
+                       std::vector<BdevSegment> &segs) {
+    size_t buf_idx = blob_info.FindBuffer(part.off_);
+    DataIterator diter(part, blob_info.GetBufferOff(buf_idx));
+    for (; buf_idx < blob_info.buffers_.size() && !diter.IsDone(); ++buf_idx) {
+      BufferInfo &buf = blob_info.buffers_[buf_idx];
+      diter.Intersect(buf);
+      if (!diter.DidIntersect()) {
+        continue;
+      }
+      if (!segs.empty()) {
+        BdevSegment &last = segs.back();
+        if (last.tid_ == buf.tid_ &&
+            last.tgt_off_ + last.size_ == diter.tgt_off_ &&
+            last.data_off_ + last.size_ == diter.data_off_) {
+          last.size_ += diter.intersect_.size_;
+          continue;
+        }
+      }
+      segs.emplace_back(BdevSegment{buf.tid_, diter.tgt_off_, diter.data_off_,
+                                    diter.intersect_.size_});
+    }
+  }
+
+  /** Wait for bdev tasks to complete and delete them */
+  template <typename TaskT>
+  void WaitBdevTasks(Task *task, std::vector<FullPtr<TaskT>> &bdev_tasks) {
+    if (bdev_tasks.empty()) {
+      return;
+    }
+    task->Wait(bdev_tasks);
+    for (FullPtr<TaskT> &bdev_task : bdev_tasks) {
+      CHI_CLIENT->DelTask(HSHM_MCTX, bdev_task);
+    }
+    bdev_tasks.clear();
+  }
+
+  /** Begin reading \a part of a blob from its targets into \a data */
+  void AsyncReadBlobPart(BlobInfo &blob_info, const Slice &part,
+                         const hipc::Pointer &data,
+                         std::vector<FullPtr<chi::bdev::ReadTask>> &tasks) {
+    std::vector<BdevSegment> segs;
+    GetBdevSegments(blob_info, part, segs);
+    for (BdevSegment &seg : segs) {
+      TargetInfo &target = *target_map_[seg.tid_];
+      tasks.emplace_back(target.client_.AsyncRead(HSHM_MCTX, target.dom_query_,
+                                                  data + seg.data_off_,
+                                                  seg.tgt_off_, seg.size_));
+    }
+  }
+
+  /** Read \a part of a blob from its targets into \a data */
+  void ReadBlobPart(Task *task, BlobInfo &blob_info, const Slice &part,
+                    const hipc::Pointer &data) {
+    std::vector<FullPtr<chi::bdev::ReadTask>> read_tasks;
+    AsyncReadBlobPart(blob_info, part, data, read_tasks);
+    WaitBdevTasks(task, read_tasks);
+  }
+
   CHI_BEGIN(PutBlob)
   /** Put a blob */
   void PutBlob(PutBlobTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    // Get blob ID and stage in the blob's old data
+    StageInBlob(task, tls, false);
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    // Get blob ID
-    chi::string blob_name(task->blob_name_);
-    if (task->blob_id_.IsNull()) {
-      task->blob_id_ = GetOrCreateBlobId(tls, task->tag_id_,
-                                         HashBlobName(task->tag_id_, blob_name),
-                                         blob_name, task->flags_);
-    }
 
     // Verify data is non-zero
     if (task->data_size_ == 0) {
@@ -951,21 +2178,13 @@ public:
 
     // Get blob struct
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob_info = it->second;
+    BlobInfo &blob_info = *blob_ptr;
     chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
 
-    // Stage Blob
-    if (blob_info.flags_.Any(HERMES_SHOULD_STAGE) &&
-        !blob_info.flags_.Any(HERMES_DID_STAGE_IN)) {
-      blob_info.flags_.SetBits(HERMES_DID_STAGE_IN);
-      client_.StageIn(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                      task->tag_id_, blob_info.name_, 1);
-    }
-
     // Determine amount of additional buffering space needed
     ssize_t bkt_size_diff = 0;
     size_t needed_space = task->blob_off_ + task->data_size_;
@@ -1001,15 +2220,15 @@ public:
         if (placement.size_ == 0) {
           continue;
         }
-        std::vector<chi::Block> blocks = target.client_.Allocate(
-            HSHM_MCTX, target.dom_query_, placement.size_);
+        std::vector<chi::Block> blocks =
+            AllocateBuffers(tls, target, placement.size_);
         // Convert to BufferInfo
         size_t t_alloc = 0;
         for (chi::Block &block : blocks) {
           if (block.size_ == 0) {
             continue;
           }
-          blob_info.buffers_.emplace_back(placement.tid_, block);
+          blob_info.AppendBuffer(placement.tid_, block);
           t_alloc += block.size_;
         }
         // HILOG(kInfo, "(node {}) Placing {}/{} bytes in target {} of bw {}",
@@ -1022,40 +2241,52 @@ public:
           size_t diff = placement.size_ - t_alloc;
           next_placement.size_ += diff;
         }
-        target.stats_->free_ -= t_alloc;
       }
     }
 
-    // Place blob in buffers
+    // Place blob in buffers. Staged-in data only fills the bytes that are
+    // still not valid: a put that raced the stage-in's read of the backend
+    // holds newer data than the read returned.
+    std::vector<Extent> parts;
+    if (task->flags_.Any(HERMES_IS_STAGE_IN)) {
+      blob_info.valid_.GetGaps(task->blob_off_, task->data_size_, parts);
+    } else {
+      parts.emplace_back(Extent{task->blob_off_, task->data_size_});
+    }
     std::vector<FullPtr<chi::bdev::WriteTask>> write_tasks;
-    write_tasks.reserve(blob_info.buffers_.size());
-    DataIterator diter(Slice{task->blob_off_, task->data_size_});
-    size_t buf_sum = 0;
-    for (BufferInfo &buf : blob_info.buffers_) {
-      diter.Intersect(buf);
-      if (diter.DidIntersect()) {
-        // HILOG(kInfo, "Writing {} bytes at off {} from target {}", buf_size,
-        //       tgt_off, buf.tid_);
-        TargetInfo &target = *target_map_[buf.tid_];
+    for (const Extent &part : parts) {
+      std::vector<BdevSegment> segs;
+      GetBdevSegments(blob_info, Slice{part.off_, part.size_}, segs);
+      hipc::Pointer data = task->data_ + (part.off_ - task->blob_off_);
+      for (BdevSegment &seg : segs) {
+        // HILOG(kInfo, "Writing {} bytes at off {} from target {}",
+        //       seg.size_, seg.tgt_off_, seg.tid_);
+        TargetInfo &target = *target_map_[seg.tid_];
         FullPtr<chi::bdev::WriteTask> write_task = target.client_.AsyncWrite(
-            HSHM_MCTX, target.dom_query_, task->data_ + diter.data_off_,
-            diter.tgt_off_, diter.intersect_.size_);
+            HSHM_MCTX, target.dom_query_, data + seg.data_off_, seg.tgt_off_,
+            seg.size_);
         write_tasks.emplace_back(write_task);
       }
-      buf_sum += buf.size_;
     }
-    blob_info.max_blob_size_ = buf_sum;
+    blob_info.max_blob_size_ = blob_info.GetBufferCapacity();
 
     // Wait for the placements to complete
     task->Wait(write_tasks);
     for (FullPtr<chi::bdev::WriteTask> &write_task : write_tasks) {
       CHI_CLIENT->DelTask(HSHM_MCTX, write_task);
     }
+    blob_info.valid_.Insert(task->blob_off_, task->data_size_);
+    if (!task->flags_.Any(HERMES_IS_STAGE_IN)) {
+      // Staged-in data already matches the backend
+      blob_info.dirty_.Insert(task->blob_off_, task->data_size_);
+    }
 
     // Update information
     if (task->flags_.Any(HERMES_SHOULD_STAGE)) {
-      STAGER_MAP_T &stager_map = tls.stager_map_;
-      chi::ScopedCoMutex stager_map_lock(tls.stager_map_lock_);
+      // Stagers live in the lane owning the tag
+      HermesLane &tag_tls = GetLaneTls(task->tag_id_.hash_);
+      STAGER_MAP_T &stager_map = tag_tls.stager_map_;
+      chi::ScopedCoMutex stager_map_lock(tag_tls.stager_map_lock_);
       auto it = stager_map.find(task->tag_id_);
       if (it == stager_map.end()) {
         HELOG(kWarning, "Could not find stager for tag {}. Not updating size",
@@ -1079,6 +2310,9 @@ public:
     // Free data
     // HILOG(kInfo, "Completing PUT for {}", task->blob_id_);
     blob_info.UpdateWriteStats();
+    if (!task->flags_.Any(HERMES_IS_STAGE_IN)) {
+      MarkDirty(tls, blob_info);
+    }
     IoStat *stat;
     hshm::qtok_t qtok = io_pattern_.push(IoStat{
         IoType::kWrite, task->blob_id_, task->tag_id_, task->data_size_, 0});
@@ -1105,14 +2339,9 @@ public:
   /** Get a blob */
   void GetBlob(GetBlobTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    // Get blob ID and stage in the blob
+    StageInBlob(task, tls, true);
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    // Get blob struct
-    if (task->blob_id_.IsNull()) {
-      chi::string blob_name(task->blob_name_);
-      task->blob_id_ = GetOrCreateBlobId(tls, task->tag_id_,
-                                         HashBlobName(task->tag_id_, blob_name),
-                                         blob_name, task->flags_);
-    }
 
     // Verify data is non-zero
     if (task->data_size_ == 0) {
@@ -1121,48 +2350,39 @@ public:
 
     // Get blob map struct
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    if (blob_map.find(task->blob_id_) == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       HELOG(kWarning, "(node {}) Attempting to get non-existent blob {}",
             CHI_CLIENT->node_id_, task->blob_id_);
       return;
     }
-    BlobInfo &blob_info = blob_map[task->blob_id_];
-
-    // Stage Blob
-    if (blob_info.flags_.Any(HERMES_SHOULD_STAGE) &&
-        !blob_info.flags_.Any(HERMES_DID_STAGE_IN)) {
-      blob_info.flags_.SetBits(HERMES_DID_STAGE_IN);
-      client_.StageIn(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                      task->tag_id_, blob_info.name_, 1);
-    }
+    BlobInfo &blob_info = *blob_ptr;
 
     // Get blob struct
     chi::ScopedCoRwReadLock blob_info_lock(blob_info.lock_);
 
     // Read blob from buffers
-    std::vector<FullPtr<chi::bdev::ReadTask>> read_tasks;
-    read_tasks.reserve(blob_info.buffers_.size());
     HILOG(kDebug,
           "(node={}) Getting blob {} of size {} starting at offset {} "
           "(total_blob_size={}, buffers={})",
           CHI_CLIENT->node_id_, task->blob_id_, task->data_size_,
           task->blob_off_, blob_info.blob_size_, blob_info.buffers_.size());
-
-    DataIterator diter(Slice{task->blob_off_, task->data_size_});
-    for (BufferInfo &buf : blob_info.buffers_) {
-      diter.Intersect(buf);
-      if (diter.DidIntersect()) {
-        // HILOG(kInfo,
-        //       "(node {}) (alloc={} data={} off={} size={}) (tgt_off={}, "
-        //       "tgt_id={})",
-        //       CHI_CLIENT->node_id_, task->data_.alloc_id_,
-        //       task->data_.off_.load(), buf_off, buf_size, tgt_off, buf.tid_);
-        TargetInfo &target = *target_map_[buf.tid_];
-        FullPtr<chi::bdev::ReadTask> read_task = target.client_.AsyncRead(
-            HSHM_MCTX, target.dom_query_, task->data_ + diter.data_off_,
-            diter.tgt_off_, diter.intersect_.size_);
-        read_tasks.emplace_back(read_task);
-      }
+    std::vector<BdevSegment> segs;
+    GetBdevSegments(blob_info, Slice{task->blob_off_, task->data_size_}, segs);
+    std::vector<FullPtr<chi::bdev::ReadTask>> read_tasks;
+    read_tasks.reserve(segs.size());
+    for (BdevSegment &seg : segs) {
+      // HILOG(kInfo,
+      //       "(node {}) (alloc={} data={} off={} size={}) (tgt_off={}, "
+      //       "tgt_id={})",
+      //       CHI_CLIENT->node_id_, task->data_.alloc_id_,
+      //       task->data_.off_.load(), seg.data_off_, seg.size_, seg.tgt_off_,
+      //       seg.tid_);
+      TargetInfo &target = *target_map_[seg.tid_];
+      FullPtr<chi::bdev::ReadTask> read_task = target.client_.AsyncRead(
+          HSHM_MCTX, target.dom_query_, task->data_ + seg.data_off_,
+          seg.tgt_off_, seg.size_);
+      read_tasks.emplace_back(read_task);
     }
     task->Wait(read_tasks);
     for (FullPtr<chi::bdev::ReadTask> &read_task : read_tasks) {
@@ -1195,11 +2415,11 @@ public:
     TAG_MAP_T &tag_map = tls.tag_map_;
 
     // Get tag info to get page size and current size
-    auto tag_it = tag_map.find(task->tag_id_);
-    if (tag_it == tag_map.end()) {
+    TagInfo *tag_ptr = tag_map.Find(task->tag_id_);
+    if (tag_ptr == nullptr) {
       return;
     }
-    TagInfo &tag = tag_it->second;
+    TagInfo &tag = *tag_ptr;
     size_t page_size = tag.page_size_ > 0
                            ? tag.page_size_
                            : MEGABYTES(1); // Default to 1MB if not set
@@ -1218,12 +2438,16 @@ public:
 
     // Do partial puts for each page
     for (size_t i = 0; i < total_pages; i++) {
-      // Create blob placement and name for this page
-      chi::string blob_name = placement.CreateBlobName();
+      // Pages of the tag are addressed by ID, or by name past the IDs
+      BlobId blob_id = GetPageBlobId(task->tag_id_, placement.page_);
+      chi::string blob_name("");
+      if (blob_id.IsNull()) {
+        blob_name = GetPageBlobName(placement.page_);
+      }
 
       // Create a PutBlob task for this page
       client_.AsyncPutBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                           task->tag_id_, blob_name, BlobId::GetNull(),
+                           task->tag_id_, blob_name, blob_id,
                            placement.blob_off_, placement.blob_size_, data,
                            task->score_, TASK_FIRE_AND_FORGET,
                            task->flags_.bits_);
@@ -1249,12 +2473,46 @@ public:
   CHI_END(AppendBlob)
 
   CHI_BEGIN(TruncateBlob)
-  /** Truncate a blob (TODO) */
+  /** Truncate a blob */
   void TruncateBlob(TruncateBlobTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    chi::ScopedCoRwWriteLock blob_map_lock(tls.blob_map_lock_);
+    BLOB_MAP_T &blob_map = tls.blob_map_;
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
+      return;
+    }
+    BlobInfo &blob = *blob_ptr;
+    if (task->size_ >= blob.blob_size_) {
+      return;
+    }
+    // Free the buffers past the new end of the blob
+    std::vector<BufferInfo> freed;
+    blob.TruncateBuffers(task->size_, freed);
+    FreeBuffers(tls, freed);
+    ssize_t bkt_size_diff = (ssize_t)task->size_ - (ssize_t)blob.blob_size_;
+    blob.blob_size_ = task->size_;
+    blob.max_blob_size_ = blob.GetBufferCapacity();
+    blob.valid_.Truncate(task->size_);
+    blob.dirty_.Truncate(task->size_);
+    blob.UpdateWriteStats();
+    MarkDirty(tls, blob);
+    // Update the tag size
+    if (!task->flags_.Any(TruncateBlobTask::kKeepTagSize)) {
+      client_.AsyncTagUpdateSize(HSHM_MCTX, chi::DomainQuery::GetDynamic(),
+                                 task->tag_id_, bkt_size_diff,
+                                 UpdateSizeMode::kAdd);
+    }
   }
   void MonitorTruncateBlob(MonitorModeId mode, TruncateBlobTask *task,
-                           RunContext &rctx) {}
+                           RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kSchedule: {
+      BlobCacheWriteRoute<TruncateBlobTask>(task);
+      return;
+    }
+    }
+  }
   CHI_END(TruncateBlob)
 
   CHI_BEGIN(DestroyBlob)
@@ -1263,26 +2521,25 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwWriteLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
-    // Free blob buffers
-    for (BufferInfo &buf : blob.buffers_) {
-      TargetInfo &target = *target_map_[buf.tid_];
-      target.client_.Free(HSHM_MCTX, target.dom_query_, buf);
-      target.stats_->free_ += buf.size_;
+    BlobInfo &blob = *blob_ptr;
+    if (task->flags_.Any(DestroyBlobTask::kStaleOnly) && !IsStaleBlob(blob)) {
+      return;
     }
+    // Free blob buffers
+    FreeBuffers(tls, blob.buffers_);
+    blob.ClearBuffers();
     // Remove blob from the tag
     if (!task->flags_.Any(DestroyBlobTask::kKeepInTag)) {
       client_.TagRemoveBlob(HSHM_MCTX, chi::DomainQuery::GetDynamic(),
                             blob.tag_id_, task->blob_id_);
     }
     // Remove the blob from the maps
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    blob_id_map.erase(blob.GetBlobNameWithBucket());
-    blob_map.erase(it);
+    RemoveBlobId(tls, blob);
+    blob_map.Erase(task->blob_id_);
   }
   void MonitorDestroyBlob(MonitorModeId mode, DestroyBlobTask *task,
                           RunContext &rctx) {
@@ -1301,11 +2558,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
+    BlobInfo &blob = *blob_ptr;
     blob.tags_.push_back(task->tag_);
   }
   void MonitorTagBlob(MonitorModeId mode, TagBlobTask *task, RunContext &rctx) {
@@ -1324,11 +2581,11 @@ public:
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    auto it = blob_map.find(task->blob_id_);
-    if (it == blob_map.end()) {
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
       return;
     }
-    BlobInfo &blob = it->second;
+    BlobInfo &blob = *blob_ptr;
     task->has_tag_ = std::find(blob.tags_.begin(), blob.tags_.end(),
                                task->tag_) != blob.tags_.end();
   }
@@ -1344,48 +2601,178 @@ public:
   CHI_END(BlobHasTag)
 
   CHI_BEGIN(ReorganizeBlob)
-  /** Change blob composition */
+  CLS_CONST size_t kMigrateChunk = MEGABYTES(1); /**< Bytes copied at once */
+
+  /**
+   * Allocate \a size bytes for a blob of \a score into \a dst. Buffers
+   * are taken from the target the score maps to first, then spill to
+   * slower targets and the fallback target. Returns the bytes allocated.
+   * */
+  size_t AllocateForScore(HermesLane &tls, float score, size_t size,
+                          BlobInfo &dst) {
+    std::vector<TargetInfo *> order;
+    TargetInfo *first = GetTargetForScore(score, size);
+    for (TargetInfo &target : targets_) {
+      if (first != nullptr && target.score_ <= first->score_) {
+        order.emplace_back(&target);
+      }
+    }
+    std::sort(order.begin(), order.end(),
+              [](const TargetInfo *a, const TargetInfo *b) {
+                return a->score_ > b->score_;
+              });
+    order.emplace_back(fallback_target_);
+    size_t alloced = 0;
+    for (TargetInfo *target : order) {
+      if (alloced >= size) {
+        break;
+      }
+      std::vector<chi::Block> blocks =
+          AllocateBuffers(tls, *target, size - alloced);
+      for (chi::Block &block : blocks) {
+        if (block.size_ == 0) {
+          continue;
+        }
+        dst.AppendBuffer(target->id_, block);
+        alloced += block.size_;
+      }
+    }
+    return alloced;
+  }
+
+  /** Whether two buffer lists name the same blocks */
+  static bool SameBuffers(const std::vector<BufferInfo> &a,
+                          const std::vector<BufferInfo> &b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i].tid_ != b[i].tid_ || a[i].off_ != b[i].off_ ||
+          a[i].size_ != b[i].size_) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Copy the first \a size bytes of \a src's buffers to \a dst's buffers.
+   * A bdev only moves data between its target and memory, so the copy
+   * alternates between two runtime chunks: the next chunk is read from
+   * \a src while the current one is written to \a dst.
+   * */
+  void CopyBuffers(Task *task, BlobInfo &src, BlobInfo &dst, size_t size) {
+    if (size == 0) {
+      return;
+    }
+    size_t chunk_size = std::min(size, kMigrateChunk);
+    FullPtr<char> chunks[2] = {
+        CHI_CLIENT->AllocateBuffer(HSHM_MCTX, chunk_size),
+        CHI_CLIENT->AllocateBuffer(HSHM_MCTX, chunk_size)};
+    std::vector<FullPtr<chi::bdev::ReadTask>> read_tasks;
+    std::vector<FullPtr<chi::bdev::WriteTask>> write_tasks;
+    AsyncReadBlobPart(src, Slice{0, chunk_size}, chunks[0].shm_, read_tasks);
+    for (size_t off = 0, idx = 0; off < size; off += chunk_size, idx ^= 1) {
+      Slice part{off, std::min(chunk_size, size - off)};
+      // The current chunk is loaded and the other chunk is free again
+      WaitBdevTasks(task, read_tasks);
+      WaitBdevTasks(task, write_tasks);
+      size_t next_off = off + part.size_;
+      if (next_off < size) {
+        Slice next{next_off, std::min(chunk_size, size - next_off)};
+        AsyncReadBlobPart(src, next, chunks[idx ^ 1].shm_, read_tasks);
+      }
+      std::vector<BdevSegment> segs;
+      GetBdevSegments(dst, part, segs);
+      for (BdevSegment &seg : segs) {
+        TargetInfo &target = *target_map_[seg.tid_];
+        write_tasks.emplace_back(target.client_.AsyncWrite(
+            HSHM_MCTX, target.dom_query_,
+            chunks[idx].shm_ + seg.data_off_, seg.tgt_off_, seg.size_));
+      }
+    }
+    WaitBdevTasks(task, write_tasks);
+    CHI_CLIENT->FreeBuffer(HSHM_MCTX, chunks[0].shm_);
+    CHI_CLIENT->FreeBuffer(HSHM_MCTX, chunks[1].shm_);
+  }
+
+  /**
+   * Change blob composition. The blob is copied to buffers on the target
+   * matching its new score holding neither the blob lock nor the blob map
+   * lock, so readers, writers, and blob creation proceed during the copy.
+   * The blob is then looked up again and its buffers swapped under the
+   * write lock, unless it was modified or destroyed meanwhile, in which
+   * case the copy is dropped and the next organizer pass retries.
+   * */
   void ReorganizeBlob(ReorganizeBlobTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    // Get blob ID
-    chi::string blob_name(task->blob_name_);
-    if (task->blob_id_.IsNull()) {
-      auto blob_id_map_it = blob_id_map.find(blob_name);
-      if (blob_id_map_it == blob_id_map.end()) {
+    BlobInfo src, dst;
+    size_t mod_count;
+    float score;
+    {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      // Get blob ID
+      if (task->blob_id_.IsNull()) {
+        task->blob_id_ = FindBlobId(tls, task->tag_id_, task->blob_name_);
+        if (task->blob_id_.IsNull()) {
+          return;
+        }
+      }
+      // Get blob struct
+      BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+      if (blob_ptr == nullptr) {
+        return;
+      }
+      BlobInfo &blob_info = *blob_ptr;
+      // Set the new score
+      if (task->is_user_score_) {
+        blob_info.user_score_ = task->score_;
+        blob_info.score_ = blob_info.user_score_;
+        blob_info.flags_.SetBits(HERMES_USER_SCORE_STATIONARY);
+      } else {
+        blob_info.score_ = task->score_;
+      }
+      // Snapshot the current layout
+      chi::ScopedCoRwReadLock blob_info_lock(blob_info.lock_);
+      if (blob_info.blob_size_ == 0 ||
+          !ShouldReorganize(blob_info, blob_info.score_)) {
         return;
       }
-      task->blob_id_ = blob_id_map_it->second;
+      for (BufferInfo &buf : blob_info.buffers_) {
+        src.AppendBuffer(buf.tid_, buf);
+      }
+      src.blob_size_ = blob_info.blob_size_;
+      mod_count = blob_info.mod_count_.load();
+      score = blob_info.score_;
+    }
+    // Copy the blob to its new buffers
+    size_t capacity = src.GetBufferCapacity();
+    if (AllocateForScore(tls, score, capacity, dst) < capacity) {
+      FreeBuffers(tls, dst.buffers_);
+      return;
     }
-    // Get blob struct
-    auto blob_map_it = blob_map.find(task->blob_id_);
-    if (blob_map_it == blob_map.end()) {
+    CopyBuffers(task, src, dst, src.blob_size_);
+    // Swap in the new buffers
+    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+    BlobInfo *blob_ptr = blob_map.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
+      FreeBuffers(tls, dst.buffers_);
       return;
     }
-    BlobInfo &blob_info = blob_map_it->second;
-    // Check if it is worth updating the score
-    // TODO(llogan)
-    // Set the new score
-    if (task->is_user_score_) {
-      blob_info.user_score_ = task->score_;
-      blob_info.score_ = blob_info.user_score_;
-    } else {
-      blob_info.score_ = task->score_;
-    }
-    // Get the blob
-    FullPtr<char> data =
-        CHI_CLIENT->AllocateBuffer(HSHM_MCTX, blob_info.blob_size_);
-    client_.GetBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0), task->tag_id_,
-                    task->blob_id_, 0, blob_info.blob_size_, data.shm_,
-                    0); // OK
-    // Put the blob with the new score
-    client_.AsyncPutBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                         task->tag_id_, chi::string(""), task->blob_id_, 0,
-                         blob_info.blob_size_, data.shm_, blob_info.score_,
-                         TASK_FIRE_AND_FORGET | TASK_DATA_OWNER,
-                         0); // OK
+    BlobInfo &blob_info = *blob_ptr;
+    chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
+    if (blob_info.mod_count_ != mod_count ||
+        !SameBuffers(blob_info.buffers_, src.buffers_)) {
+      FreeBuffers(tls, dst.buffers_);
+      return;
+    }
+    blob_info.ClearBuffers();
+    for (BufferInfo &buf : dst.buffers_) {
+      blob_info.AppendBuffer(buf.tid_, buf);
+    }
+    blob_info.max_blob_size_ = blob_info.GetBufferCapacity();
+    FreeBuffers(tls, src.buffers_);
   }
   void MonitorReorganizeBlob(MonitorModeId mode, ReorganizeBlobTask *task,
                              RunContext &rctx) {
@@ -1399,31 +2786,247 @@ public:
   CHI_END(ReorganizeBlob)
 
   CHI_BEGIN(ReorganizeNode)
-  /** The ReorganizeNode method */
+  /** A blob the organizer wants to move */
+  struct ReorgCandidate {
+    TagId tag_id_;
+    BlobId blob_id_;
+    float score_;
+    float delta_;
+    size_t size_;
+    TargetInfo *tgt_;
+  };
+
+  /** Score a blob from how recently and how often it was accessed */
+  float MakeScore(BlobInfo &blob_info, hshm::Timepoint &now) {
+    config::BorgInfo &borg = HERMES_SERVER_CONF.borg_;
+    float elapsed = (float)blob_info.last_access_.GetSecFromStart(now);
+    float recency_range =
+        std::max(borg.recency_max_ - borg.recency_min_, 1e-6f);
+    float freq_range = std::max(borg.freq_max_ - borg.freq_min_, 1e-6f);
+    float recency_score = 1 - (elapsed - borg.recency_min_) / recency_range;
+    float freq_score = (blob_info.access_freq_ - borg.freq_min_) / freq_range;
+    float score = std::max(recency_score, freq_score);
+    return std::clamp(score, 0.0f, 1.0f);
+  }
+
+  /**
+   * The target the DPE would choose for a blob of \a score: the fastest
+   * target not scoring above the blob that can hold \a size more bytes
+   * without going over its max threshold.
+   * */
+  TargetInfo *GetTargetForScore(float score, size_t size) {
+    TargetInfo *best = nullptr;
+    for (TargetInfo &target : targets_) {
+      if (target.score_ > score) {
+        continue;
+      }
+      if (!target.HasRoom(size)) {
+        // The room may be sitting idle in other lanes' caches
+        if (target.GetRemCap() < size &&
+            target.GetRemCap() + target.GetCached() >= size) {
+          target.RequestDrain();
+        }
+        continue;
+      }
+      if (best == nullptr || target.score_ > best->score_) {
+        best = &target;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * Whether any buffer of the blob is off the target its score maps to.
+   * Blobs are not demoted out of a target below its min threshold.
+   * */
+  bool ShouldReorganize(BlobInfo &blob_info, float score) {
+    TargetInfo *dst = GetTargetForScore(score, blob_info.blob_size_);
+    if (dst == nullptr) {
+      return false;
+    }
+    for (BufferInfo &buf : blob_info.buffers_) {
+      if (buf.tid_ == dst->id_) {
+        continue;
+      }
+      TargetInfo *src = target_map_[buf.tid_];
+      if (dst->score_ < src->score_ &&
+          src->GetUsage() < src->borg_min_thresh_) {
+        continue;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /** The target holding most of a blob's bytes */
+  TargetInfo *GetMainTarget(BlobInfo &blob_info) {
+    TargetInfo *main = nullptr;
+    size_t main_size = 0;
+    for (size_t i = 0; i < blob_info.buffers_.size(); ++i) {
+      TargetId tid = blob_info.buffers_[i].tid_;
+      size_t size = 0;
+      for (BufferInfo &buf : blob_info.buffers_) {
+        if (buf.tid_ == tid) {
+          size += buf.size_;
+        }
+      }
+      if (size > main_size) {
+        main = target_map_[tid];
+        main_size = size;
+      }
+    }
+    return main;
+  }
+
+  /** The fastest target slower than \a target */
+  TargetInfo *GetNextTarget(TargetInfo &target) {
+    TargetInfo *next = nullptr;
+    for (TargetInfo &other : targets_) {
+      if (other.score_ >= target.score_) {
+        continue;
+      }
+      if (next == nullptr || other.score_ > next->score_) {
+        next = &other;
+      }
+    }
+    return next;
+  }
+
+  /** Whether any target is outside its [min, max] capacity thresholds */
+  bool AnyTargetOffThresh() {
+    for (TargetInfo &target : targets_) {
+      float usage = target.GetUsage();
+      if (usage > target.borg_max_thresh_ ||
+          usage < target.borg_min_thresh_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Send a blob to the tier matching \a score in the background */
+  void MoveBlob(const ReorgCandidate &cand, float score, size_t &budget) {
+    budget -= cand.size_;
+    client_.AsyncReorganizeBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
+                                cand.tag_id_, chi::string(""), cand.blob_id_,
+                                score, false, Context(),
+                                TASK_FIRE_AND_FORGET); // OK
+  }
+
+  /**
+   * Enforce borg_capacity_thresh. A target above its max threshold
+   * demotes its lowest-scored blobs to the next slower target; a target
+   * below its min threshold back-fills with the highest-scored blobs of
+   * slower targets. Each lane moves its share of the excess or room.
+   * \a residents is sorted by ascending score.
+   * */
+  void BalanceTargets(std::vector<ReorgCandidate> &residents,
+                      std::unordered_set<BlobId> &moved, size_t &budget) {
+    for (TargetInfo &target : targets_) {
+      size_t max_cap = target.stats_->max_cap_;
+      float usage = target.GetUsage();
+      if (usage > target.borg_max_thresh_) {
+        TargetInfo *next = GetNextTarget(target);
+        if (next == nullptr) {
+          continue;
+        }
+        size_t excess = (size_t)((usage - target.borg_max_thresh_) * max_cap /
+                                 HERMES_LANES);
+        for (ReorgCandidate &cand : residents) {
+          if (excess == 0) {
+            break;
+          }
+          if (cand.tgt_ != &target || cand.size_ > budget ||
+              moved.count(cand.blob_id_)) {
+            continue;
+          }
+          moved.emplace(cand.blob_id_);
+          excess -= std::min(excess, cand.size_);
+          MoveBlob(cand, next->score_, budget);
+        }
+      } else if (usage < target.borg_min_thresh_) {
+        size_t room = (size_t)((target.borg_min_thresh_ - usage) * max_cap /
+                               HERMES_LANES);
+        for (auto it = residents.rbegin(); it != residents.rend(); ++it) {
+          ReorgCandidate &cand = *it;
+          if (cand.size_ > room || cand.size_ > budget) {
+            continue;
+          }
+          if (cand.tgt_->score_ >= target.score_ ||
+              moved.count(cand.blob_id_)) {
+            continue;
+          }
+          moved.emplace(cand.blob_id_);
+          room -= cand.size_;
+          MoveBlob(cand, target.score_, budget);
+        }
+      }
+    }
+  }
+
+  /**
+   * Periodically rescore the blobs of this lane, decay their access
+   * counts, and move the blobs whose score changed the most to the tier
+   * matching their new score. Capacity thresholds are enforced first.
+   * At most blob_reorg_max_bytes_ per node are moved each period so
+   * migration does not starve foreground I/O.
+   * */
   void ReorganizeNode(ReorganizeNodeTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    BLOB_MAP_T &blob_map = tls.blob_map_;
-    for (auto &it : blob_map) {
-      BlobInfo &blob_info = it.second;
-      // Update blob scores
-      //      float new_score = MakeScore(blob_info, now);
-      //      blob_info.score_ = new_score;
-      //      if (ShouldReorganize<true>(blob_info, new_score,
-      //      task->task_node_)) {
-      //        Context ctx;
-      //        FullPtr<ReorganizeBlobTask> reorg_task =
-      //            blob_mdm_.AsyncReorganizeBlob(task->task_node_ + 1,
-      //                                          blob_info.tag_id_,
-      //                                          chi::string(""),
-      //                                          blob_info.blob_id_,
-      //                                          new_score, false, ctx,
-      //                                          TASK_LOW_LATENCY);
-      //        reorg_task->Wait<TASK_YIELD_CO>(task);
-      //        CHI_CLIENT->DelTask(HSHM_MCTX, reorg_task);
-      //      }
-      //      blob_info.access_freq_ = 0;
+    config::BorgInfo &borg = HERMES_SERVER_CONF.borg_;
+    std::vector<ReorgCandidate> candidates, residents;
+    bool balance = AnyTargetOffThresh();
+    {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      BLOB_MAP_T &blob_map = tls.blob_map_;
+      hshm::Timepoint now;
+      now.Now();
+      blob_map.ForEach([&](const BlobId &blob_id, BlobInfo &blob_info) {
+        float score = MakeScore(blob_info, now);
+        blob_info.access_freq_ =
+            (u32)(blob_info.access_freq_.load() * borg.freq_decay_);
+        if (blob_info.flags_.Any(HERMES_USER_SCORE_STATIONARY) ||
+            blob_info.blob_size_ == 0 || IsStaleBlob(blob_info)) {
+          return;
+        }
+        TargetInfo *tgt = GetMainTarget(blob_info);
+        if (balance && tgt) {
+          residents.emplace_back(ReorgCandidate{blob_info.tag_id_, blob_id,
+                                                score, 0,
+                                                blob_info.blob_size_, tgt});
+        }
+        float delta = std::fabs(score - blob_info.score_);
+        if (delta < borg.blob_reorg_min_delta_ ||
+            !ShouldReorganize(blob_info, score)) {
+          return;
+        }
+        candidates.emplace_back(ReorgCandidate{blob_info.tag_id_, blob_id,
+                                               score, delta,
+                                               blob_info.blob_size_, tgt});
+      });
+    }
+    size_t budget = borg.blob_reorg_max_bytes_ / HERMES_LANES;
+    std::unordered_set<BlobId> moved;
+    if (balance) {
+      std::sort(residents.begin(), residents.end(),
+                [](const ReorgCandidate &a, const ReorgCandidate &b) {
+                  return a.score_ < b.score_;
+                });
+      BalanceTargets(residents, moved, budget);
+    }
+    // Move the blobs whose score changed the most first
+    std::sort(candidates.begin(), candidates.end(),
+              [](const ReorgCandidate &a, const ReorgCandidate &b) {
+                return a.delta_ > b.delta_;
+              });
+    for (ReorgCandidate &cand : candidates) {
+      if (cand.size_ > budget) {
+        break;
+      }
+      if (moved.count(cand.blob_id_)) {
+        continue;
+      }
+      MoveBlob(cand, cand.score_, budget);
     }
   }
   void MonitorReorganizeNode(MonitorModeId mode, ReorganizeNodeTask *task,
@@ -1440,65 +3043,166 @@ public:
   /** Check if blob needs to be flushed */
   bool _BlobNeedsFlush(BlobInfo &blob_info) {
     return blob_info.flags_.Any(HERMES_SHOULD_STAGE) &&
-           blob_info.mod_count_ > blob_info.last_flush_;
+           !blob_info.dirty_.empty() && !IsStaleBlob(blob_info);
   }
 
   /** Check if any blobs need to be flushed */
   bool _AnyBlobNeedsFlush() {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
-    BLOB_MAP_T &blob_map = tls.blob_map_;
-    for (auto &it : blob_map) {
-      BlobInfo &blob_info = it.second;
-      if (_BlobNeedsFlush(blob_info)) {
-        return true;
+    chi::ScopedCoMutex dirty_lock(tls.dirty_lock_);
+    return !tls.dirty_blobs_.empty();
+  }
+
+  /** A dirty blob awaiting flush and its page in the backend */
+  struct FlushPage {
+    BlobId blob_id_;
+    size_t page_;
+  };
+
+  /** The stager of a tag, or null. Stagers live in the tag's lane. */
+  std::shared_ptr<AbstractStager> GetStager(const TagId &tag_id) {
+    HermesLane &tag_tls = GetLaneTls(tag_id.hash_);
+    chi::ScopedCoMutex stager_map_lock(tag_tls.stager_map_lock_);
+    auto it = tag_tls.stager_map_.find(tag_id);
+    if (it == tag_tls.stager_map_.end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
+
+  /**
+   * Flush the dirty \a pages of a tag, sorted by page. Blobs are read from
+   * their targets straight into \a buf and handed to the stager without
+   * going through GetBlob or StageOut tasks. Consecutive fully dirty pages
+   * are read back to back and staged out as one write of at most
+   * flush_max_bytes_, aligned to that size in the backend. Partly dirty
+   * pages only write their dirty extents.
+   * */
+  void _FlushPages(Task *task, HermesLane &tls, const TagId &tag_id,
+                   const std::vector<FlushPage> &pages, FlushBuffer &buf) {
+    std::shared_ptr<AbstractStager> stager = GetStager(tag_id);
+    if (stager == nullptr) {
+      HELOG(kError, "Could not find stager for bucket: {}", tag_id);
+      return;
+    }
+    size_t page_size = stager->GetPageSize();
+    size_t max_bytes =
+        std::max(HERMES_SERVER_CONF.borg_.flush_max_bytes_, page_size);
+    FlushBatch batch(
+        buf, *stager, client_, tag_id,
+        std::max(HERMES_SERVER_CONF.borg_.flush_batch_bytes_, max_bytes));
+    std::vector<FlushSpan> run;
+    size_t run_off = 0;
+    size_t run_size = 0;
+    size_t next_page = 0;
+    auto stage_run = [&]() {
+      HILOG(kDebug, "Flushing {} blobs ({} bytes) of tag {}", run.size(),
+            run_size, tag_id);
+      batch.Add(run[0].blob_->name_.str(), 0, run_off, run_size,
+                std::move(run));
+      batch.used_ = run_off + run_size;
+      run.clear();
+      run_size = 0;
+    };
+    for (const FlushPage &page : pages) {
+      BlobInfo *blob_ptr = tls.blob_map_.Find(page.blob_id_);
+      if (blob_ptr == nullptr) {
+        continue;
+      }
+      BlobInfo &blob_info = *blob_ptr;
+      // Take the dirty ranges. Writes from here on dirty the blob again,
+      // and ranges whose write fails are put back by _RestoreDirty.
+      IntervalSet dirty;
+      hshm::big_uint last_flush;
+      {
+        chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
+        if (!_BlobNeedsFlush(blob_info)) {
+          continue;
+        }
+        dirty.swap(blob_info.dirty_);
+        last_flush = blob_info.last_flush_.load();
+        blob_info.last_flush_ = blob_info.mod_count_.load();
+      }
+      chi::ScopedCoRwReadLock blob_info_lock(blob_info.lock_);
+      if (!dirty.Contains(0, blob_info.blob_size_)) {
+        if (!run.empty()) {
+          stage_run();
+        }
+        _FlushExtents(task, tag_id, blob_info, dirty, last_flush, batch);
+        continue;
       }
+      // Only pages directly following a run of full pages extend it
+      bool extends = !run.empty() && page_size > 0 &&
+                     page.page_ == next_page &&
+                     run_size == run.size() * page_size &&
+                     run_size + blob_info.blob_size_ <= max_bytes &&
+                     (page.page_ * page_size) % max_bytes != 0;
+      if (!run.empty() && !extends) {
+        stage_run();
+      }
+      if (run.empty()) {
+        run_off =
+            batch.Reserve(task, std::max(max_bytes, blob_info.blob_size_));
+      }
+      ReadBlobPart(task, blob_info, Slice{0, blob_info.blob_size_},
+                   buf.data_.shm_ + run_off + run_size);
+      run.emplace_back(FlushSpan{&blob_info, 0, run_size,
+                                 blob_info.blob_size_, last_flush});
+      run_size += blob_info.blob_size_;
+      next_page = page.page_ + 1;
     }
-    return false;
+    if (!run.empty()) {
+      stage_run();
+    }
+    batch.Flush(task);
+    _RestoreDirty(tls, batch.failed_);
   }
 
-  /** FlushBlob */
-  void _FlushBlob(HermesLane &tls, BlobId blob_id, RunContext &rctx) {
-    BLOB_MAP_T &blob_map = tls.blob_map_;
-    // Can we find the blob
-    auto it = blob_map.find(blob_id);
-    if (it == blob_map.end()) {
-      return;
-    }
-    BlobInfo &blob_info = it->second;
-    chi::ScopedCoRwReadLock blob_map_lock(blob_info.lock_);
-    FlushInfo flush_info;
-    flush_info.blob_info_ = &blob_info;
-    flush_info.mod_count_ = blob_info.mod_count_;
-    // Is the blob already flushed?
-    if (!_BlobNeedsFlush(blob_info)) {
-      return;
-    }
-    HILOG(kDebug, "Flushing blob {} (mod_count={}, last_flush={})",
-          blob_info.blob_id_, flush_info.mod_count_, blob_info.last_flush_);
-    FullPtr<char> data =
-        CHI_CLIENT->AllocateBuffer(HSHM_MCTX, blob_info.blob_size_);
-    client_.GetBlob(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                    blob_info.tag_id_, blob_info.blob_id_, 0,
-                    blob_info.blob_size_, data.shm_, 0); // OK
-    adapter::BlobPlacement plcmnt;
-    plcmnt.DecodeBlobName(blob_info.name_, 4096);
-    HILOG(kDebug, "Flushing blob {} with first entry {}", plcmnt.page_,
-          (int)data.ptr_[0]);
-    client_.StageOut(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
-                     blob_info.tag_id_, blob_info.name_, data.shm_,
-                     blob_info.blob_size_,
-                     TASK_DATA_OWNER); // OK
-    HILOG(kDebug, "Finished flushing blob {} with first entry {}", plcmnt.page_,
-          (int)data.ptr_[0]);
-    blob_info.last_flush_ = flush_info.mod_count_;
+  /**
+   * Put the ranges that failed to flush back into their blobs' dirty sets
+   * and queue the blobs for the next flush, so no write is dropped
+   * */
+  void _RestoreDirty(HermesLane &tls, const std::vector<FlushSpan> &failed) {
+    for (const FlushSpan &span : failed) {
+      BlobInfo &blob_info = *span.blob_;
+      {
+        chi::ScopedCoRwWriteLock blob_info_lock(blob_info.lock_);
+        blob_info.dirty_.Insert(span.blob_off_, span.size_);
+        blob_info.last_flush_ =
+            std::min(blob_info.last_flush_.load(), span.last_flush_);
+      }
+      MarkDirty(tls, blob_info);
+    }
+  }
+
+  /** Stage out the \a dirty extents of a blob, one write per extent */
+  void _FlushExtents(Task *task, const TagId &tag_id, BlobInfo &blob_info,
+                     const IntervalSet &dirty, hshm::big_uint last_flush,
+                     FlushBatch &batch) {
+    std::vector<Extent> extents;
+    dirty.GetExtents(0, blob_info.blob_size_, extents);
+    for (const Extent &extent : extents) {
+      size_t off = batch.Reserve(task, extent.size_);
+      ReadBlobPart(task, blob_info, Slice{extent.off_, extent.size_},
+                   batch.buf_.data_.shm_ + off);
+      batch.Add(blob_info.name_.str(), extent.off_, off, extent.size_,
+                {FlushSpan{&blob_info, extent.off_, 0, extent.size_,
+                           last_flush}});
+    }
+    HILOG(kDebug, "Flushing {} extents of blob {} of tag {}", extents.size(),
+          blob_info.blob_id_, tag_id);
   }
 
   void FlushBlob(FlushBlobTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    _FlushBlob(tls, task->blob_id_, rctx);
+    BlobInfo *blob_ptr = tls.blob_map_.Find(task->blob_id_);
+    if (blob_ptr == nullptr) {
+      return;
+    }
+    FlushBuffer buf;
+    _FlushPages(task, tls, blob_ptr->tag_id_, {FlushPage{task->blob_id_, 0}},
+                buf);
   }
   void MonitorFlushBlob(MonitorModeId mode, FlushBlobTask *task,
                         RunContext &rctx) {}
@@ -1508,12 +3212,37 @@ public:
   /** Flush blobs back to storage */
   void FlushData(FlushDataTask *task, RunContext &rctx) {
     HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
+    ReclaimStaleBlobs(tls);
+    DrainRequestedCaches(tls);
+    FlushTrace(tls);
     chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    BLOB_ID_MAP_T &blob_id_map = tls.blob_id_map_;
     BLOB_MAP_T &blob_map = tls.blob_map_;
-    for (auto &it : blob_map) {
-      BlobInfo &blob_info = it.second;
-      _FlushBlob(tls, blob_info.blob_id_, rctx);
+    // Take the dirty set so blobs modified while flushing queue again
+    DIRTY_SET_T dirty;
+    {
+      chi::ScopedCoMutex dirty_lock(tls.dirty_lock_);
+      dirty.swap(tls.dirty_blobs_);
+    }
+    // Group the dirty pages by tag so neighboring pages merge into one write
+    std::unordered_map<TagId, std::vector<FlushPage>> tag_pages;
+    for (const BlobId &blob_id : dirty) {
+      BlobInfo *blob_ptr = blob_map.Find(blob_id);
+      if (blob_ptr == nullptr) {
+        continue;
+      }
+      adapter::BlobPlacement plcmnt;
+      plcmnt.DecodeBlobName(blob_ptr->name_, 0);
+      tag_pages[blob_ptr->tag_id_].emplace_back(
+          FlushPage{blob_id, plcmnt.page_});
+    }
+    FlushBuffer buf;
+    for (auto &it : tag_pages) {
+      std::vector<FlushPage> &pages = it.second;
+      std::sort(pages.begin(), pages.end(),
+                [](const FlushPage &a, const FlushPage &b) {
+                  return a.page_ < b.page_;
+                });
+      _FlushPages(task, tls, it.first, pages, buf);
     }
   }
   void MonitorFlushData(MonitorModeId mode, FlushDataTask *task,
@@ -1530,6 +3259,72 @@ public:
   }
   CHI_END(FlushData)
 
+  CHI_BEGIN(PutBlobBatch)
+  /** Put a batch of blobs, fanning out to the lanes owning each blob */
+  void PutBlobBatch(PutBlobBatchTask *task, RunContext &rctx) {
+    std::string names = task->names_.str();
+    u32 hermes_flags = task->flags_.bits_ | HERMES_GET_BLOB_ID;
+    std::vector<FullPtr<PutBlobTask>> put_tasks;
+    put_tasks.reserve(task->entries_.size());
+    for (BlobBatchEntry &entry : task->entries_) {
+      put_tasks.emplace_back(client_.AsyncPutBlob(
+          HSHM_MCTX, chi::DomainQuery::GetDynamic(), task->tag_id_,
+          entry.GetBlobName(names), entry.blob_id_, entry.blob_off_,
+          entry.data_size_, entry.data_, task->score_, 0, hermes_flags));
+    }
+    task->Wait(put_tasks);
+    for (size_t i = 0; i < put_tasks.size(); ++i) {
+      task->entries_[i].blob_id_ = put_tasks[i]->blob_id_;
+      CHI_CLIENT->DelTask(HSHM_MCTX, put_tasks[i]);
+    }
+  }
+  void MonitorPutBlobBatch(MonitorModeId mode, PutBlobBatchTask *task,
+                           RunContext &rctx) {}
+  CHI_END(PutBlobBatch)
+
+  CHI_BEGIN(GetBlobBatch)
+  /** Get a batch of blobs, fanning out to the lanes owning each blob */
+  void GetBlobBatch(GetBlobBatchTask *task, RunContext &rctx) {
+    std::string names = task->names_.str();
+    if (task->flags_.Any(HERMES_GET_BLOB_SIZE)) {
+      GetBlobBatchSizes(task, names);
+      return;
+    }
+    u32 hermes_flags = task->flags_.bits_ | HERMES_GET_BLOB_ID;
+    std::vector<FullPtr<GetBlobTask>> get_tasks;
+    get_tasks.reserve(task->entries_.size());
+    for (BlobBatchEntry &entry : task->entries_) {
+      get_tasks.emplace_back(client_.AsyncGetBlob(
+          HSHM_MCTX, chi::DomainQuery::GetDynamic(), task->tag_id_,
+          entry.GetBlobName(names), entry.blob_id_, entry.blob_off_,
+          entry.data_size_, entry.data_, hermes_flags));
+    }
+    task->Wait(get_tasks);
+    for (size_t i = 0; i < get_tasks.size(); ++i) {
+      task->entries_[i].blob_id_ = get_tasks[i]->blob_id_;
+      task->entries_[i].data_size_ = get_tasks[i]->data_size_;
+      CHI_CLIENT->DelTask(HSHM_MCTX, get_tasks[i]);
+    }
+  }
+  /** Get the size of each blob of a batch instead of its data */
+  void GetBlobBatchSizes(GetBlobBatchTask *task, const std::string &names) {
+    std::vector<FullPtr<GetBlobSizeTask>> size_tasks;
+    size_tasks.reserve(task->entries_.size());
+    for (BlobBatchEntry &entry : task->entries_) {
+      size_tasks.emplace_back(client_.AsyncGetBlobSize(
+          HSHM_MCTX, chi::DomainQuery::GetDynamic(), task->tag_id_,
+          entry.GetBlobName(names), entry.blob_id_));
+    }
+    task->Wait(size_tasks);
+    for (size_t i = 0; i < size_tasks.size(); ++i) {
+      task->entries_[i].data_size_ = size_tasks[i]->size_;
+      CHI_CLIENT->DelTask(HSHM_MCTX, size_tasks[i]);
+    }
+  }
+  void MonitorGetBlobBatch(MonitorModeId mode, GetBlobBatchTask *task,
+                           RunContext &rctx) {}
+  CHI_END(GetBlobBatch)
+
   /** Monitor function used by all metadata poll functions */
   template <typename PollTaskT, typename MD>
   void MonitorPollMetadata(MonitorModeId mode, PollTaskT *task,
@@ -1559,20 +3354,19 @@ public:
   CHI_BEGIN(PollBlobMetadata)
   /** Poll blob metadata */
   void PollBlobMetadata(PollBlobMetadataTask *task, RunContext &rctx) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
-    BLOB_MAP_T &blob_map = tls.blob_map_;
     std::vector<BlobInfo> blob_mdms;
-    blob_mdms.reserve(blob_map.size());
     std::string filter = task->filter_.str();
-    for (const std::pair<BlobId, BlobInfo> &blob_part : blob_map) {
-      const BlobInfo &blob_info = blob_part.second;
-      if (!filter.empty()) {
-        if (!std::regex_match(blob_info.name_.str(), std::regex(filter))) {
-          continue;
+    for (HermesLane &tls : tls_) {
+      chi::ScopedCoRwReadLock blob_map_lock(tls.blob_map_lock_);
+      BLOB_MAP_T &blob_map = tls.blob_map_;
+      blob_map.ForEach([&](const BlobId &blob_id, BlobInfo &blob_info) {
+        if (!filter.empty()) {
+          if (!std::regex_match(blob_info.name_.str(), std::regex(filter))) {
+            return;
+          }
         }
-      }
-      blob_mdms.emplace_back(blob_info);
+        blob_mdms.emplace_back(blob_info);
+      });
     }
     task->SetStats(blob_mdms);
   }
@@ -1595,7 +3389,7 @@ public:
       TargetStats stats;
       stats.tgt_id_ = bdev_client.id_;
       stats.node_id_ = CHI_CLIENT->node_id_;
-      stats.rem_cap_ = bdev_client.stats_->free_;
+      stats.rem_cap_ = bdev_client.GetRemCap();
       stats.max_cap_ = bdev_client.stats_->max_cap_;
       stats.bandwidth_ = bdev_client.stats_->write_bw_;
       stats.latency_ = bdev_client.stats_->write_latency_;
@@ -1614,19 +3408,19 @@ public:
   CHI_BEGIN(PollTagMetadata)
   /** The PollTagMetadata method */
   void PollTagMetadata(PollTagMetadataTask *task, RunContext &rctx) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
-    TAG_MAP_T &tag_map = tls.tag_map_;
     std::vector<TagInfo> stats;
     std::string filter = task->filter_.str();
-    for (auto &it : tag_map) {
-      TagInfo &tag = it.second;
-      if (!filter.empty()) {
-        if (!std::regex_match(tag.name_.str(), std::regex(filter))) {
-          continue;
+    for (HermesLane &tls : tls_) {
+      chi::ScopedCoRwReadLock tag_map_lock(tls.tag_map_lock_);
+      TAG_MAP_T &tag_map = tls.tag_map_;
+      tag_map.ForEach([&](const TagId &tag_id, TagInfo &tag) {
+        if (!filter.empty()) {
+          if (!std::regex_match(tag.name_.str(), std::regex(filter))) {
+            return;
+          }
         }
-      }
-      stats.emplace_back(tag);
+        stats.emplace_back(tag);
+      });
     }
     task->SetStats(stats);
   }
@@ -1721,19 +3515,45 @@ public:
   CHI_BEGIN(StageIn)
   /** The StageIn method */
   void StageIn(StageInTask *task, RunContext &rctx) {
-    HermesLane &tls = tls_[CHI_CUR_LANE->lane_id_];
-    chi::ScopedCoMutex stager_map_lock(tls.stager_map_lock_);
-    STAGER_MAP_T &stager_map = tls.stager_map_;
-    STAGER_MAP_T::iterator it = stager_map.find(task->bkt_id_);
-    if (it == stager_map.end()) {
+    std::shared_ptr<AbstractStager> stager = GetStager(task->bkt_id_);
+    if (stager == nullptr) {
       // HELOG(kError, "Could not find stager for bucket: {}", task->bkt_id_);
       // TODO(llogan): Probably should add back...
       // task->SetModuleComplete();
       return;
     }
-    std::shared_ptr<AbstractStager> &stager = it->second;
-    stager->StageIn(HSHM_MCTX, client_, task->bkt_id_, task->blob_name_.str(),
-                    task->score_);
+    size_t page_size = stager->GetPageSize();
+    if (page_size == 0 || task->blob_off_ >= page_size) {
+      stager->StageIn(HSHM_MCTX, client_, task->bkt_id_,
+                      task->blob_name_.str(), task->blob_off_,
+                      task->data_size_, task->score_);
+      return;
+    }
+    // Read through the stager's queue, yielding so that other stage-ins
+    // of this lane are issued while the read is in flight
+    std::vector<StageIo> ios(1);
+    StageIo &io = ios[0];
+    io.blob_name_ = task->blob_name_.str();
+    io.blob_off_ = task->blob_off_;
+    io.size_ = task->data_size_;
+    if (io.size_ == 0 || io.blob_off_ + io.size_ > page_size) {
+      io.size_ = page_size - io.blob_off_;
+    }
+    io.is_read_ = true;
+    FullPtr<char> data = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io.size_);
+    io.data_ = data.shm_;
+    stager->Submit(HSHM_MCTX, client_, task->bkt_id_, ios);
+    while (!stager->Reap(ios)) {
+      task->Yield();
+    }
+    if (io.result_ <= 0) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data.shm_);
+      return;
+    }
+    client_.PutBlob(HSHM_MCTX, chi::DomainQuery::GetDynamic(), task->bkt_id_,
+                    chi::string(io.blob_name_), BlobId::GetNull(),
+                    io.blob_off_, (size_t)io.result_, data.shm_,
+                    task->score_, TASK_DATA_OWNER, HERMES_IS_STAGE_IN);
   }
   void MonitorStageIn(MonitorModeId mode, StageInTask *task, RunContext &rctx) {
     switch (mode) {
@@ -1757,7 +3577,7 @@ public:
     }
     std::shared_ptr<AbstractStager> &stager = it->second;
     stager->StageOut(HSHM_MCTX, client_, task->bkt_id_, task->blob_name_.str(),
-                     task->data_, task->data_size_);
+                     0, task->data_, task->data_size_);
   }
   void MonitorStageOut(MonitorModeId mode, StageOutTask *task,
                        RunContext &rctx) {
@@ -30,7 +30,7 @@ class HermesApiBench(Application):
                 'msg': 'The benchmark to run',
                 'type': str,
                 'default': None,
-                'choices': ['putget', 'pputget', 'create_bkt',
+                'choices': ['putget', 'pputget', 'scale', 'create_bkt',
                             'get_bkt', 'del_bkt'],
             },
             {
@@ -63,6 +63,18 @@ class HermesApiBench(Application):
                 'type': str,
                 'default': '1',
             },
+            {
+                'name': 'max_threads',
+                'msg': 'The largest client thread count swept by scale',
+                'type': str,
+                'default': '16',
+            },
+            {
+                'name': 'workers',
+                'msg': 'The runtime worker count, used to label scale results',
+                'type': str,
+                'default': '1',
+            },
             {
                 'name': 'nprocs',
                 'msg': 'The number of processes to spawn',
@@ -107,6 +119,13 @@ class HermesApiBench(Application):
                 self.config['part_size'],
                 self.config['blobs_per_rank']
             ]
+        elif mode == 'scale':
+            cmd += [
+                self.config['blob_size'],
+                self.config['blobs_per_rank'],
+                self.config['max_threads'],
+                self.config['workers']
+            ]
         elif mode == 'create_bkt':
             cmd += [
                 self.config['bkts_per_rank']
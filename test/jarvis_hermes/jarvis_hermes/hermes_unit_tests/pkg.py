@@ -72,13 +72,29 @@ class HermesUnitTests(Application):
         test_hermes_execs = [
             'TestHermesConnect', 'TestHermesPut1n', 'TestHermesPut', 'TestHermesSerializedPutGet',
             'TestHermesAsyncPut', 'TestHermesAsyncPutLocalFlush', 'TestHermesPutGet',
-            'TestHermesPartialPutGet', 'TestHermesBlobDestroy',
+            'TestHermesPartialPutGet', 'TestHermesBatchPutGet',
+            'TestHermesBlobDestroy',
+            'TestHermesBlobTruncate',
+            'TestHermesBucketClear', 'TestHermesBucketClearMultiNode',
             'TestHermesBucketDestroy', 'TestHermesReorganizeBlob',
             'TestHermesBucketAppend', 'TestHermesBucketAppend1n',
             'TestHermesConnect', 'TestHermesGetContainedBlobIds',
             'TestHermesMultiGetBucket', 'TestHermesDataStager',
             'TestHermesDataOp', 'TestHermesCollectMetadata', 'TestHermesDataPlacement',
-            'TestHermesDataPlacementFancy', 'TestHermesCompress', 'hermes'
+            'TestHermesDataPlacementFancy', 'TestHermesCompress',
+            'TestMetadataIndex', 'TestMetadataTable',
+            'TestBlobNameKey',
+            'TestPageBlobId',
+            'TestBlobBuffers',
+            'TestBufferCache', 'TestTargetCached',
+            'TestBlobTruncateBuffers',
+            'TestTargetCapacity',
+            'TestReadAhead',
+            'TestAprioriSchema',
+            'TestIntervalSet',
+            'TestCompressStager', 'TestCompressStagerPageSize',
+            'TestDirectStagerUnaligned', 'TestIoUringStagerBatch',
+            'TestIoUringStagerFallback', 'hermes'
         ]
         test_latency_execs = ['TestRoundTripLatency',
                               'TestHshmQueueAllocateEmplacePop',
@@ -0,0 +1,42 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/apriori_schema.h"
+
+TEST_CASE("TestAprioriSchema") {
+  std::vector<hermes::TraceRead> trace;
+  hermes::TraceRead read;
+  REQUIRE(hermes::AprioriSchema::ParseTraceLine("0 4 /tmp/a b", read));
+  REQUIRE(read.page_ == 4);
+  REQUIRE(read.bkt_name_ == "/tmp/a b");
+  REQUIRE(!hermes::AprioriSchema::ParseTraceLine("0 4", read));
+  // Rank 0 reads /a page 0 and then pages 8 and 9 of /b
+  trace.emplace_back(hermes::TraceRead{0, 0, "/a"});
+  trace.emplace_back(hermes::TraceRead{0, 8, "/b"});
+  trace.emplace_back(hermes::TraceRead{0, 9, "/b"});
+  hermes::AprioriSchema schema =
+      hermes::AprioriSchema::Derive(trace, 2, .5);
+  std::vector<const hermes::AprioriRule *> rules;
+  schema.Find("/a", 0, rules);
+  REQUIRE(rules.size() == 1);
+  REQUIRE(rules[0]->prefetch_.size() == 1);
+  const hermes::AprioriPrefetch &prefetch = rules[0]->prefetch_[0];
+  REQUIRE(prefetch.pages_.bkt_name_ == "/b");
+  REQUIRE(prefetch.pages_.begin_ == 8);
+  REQUIRE(prefetch.pages_.end_ == 9);
+  REQUIRE(prefetch.score_ == .5);
+  rules.clear();
+  schema.Find("/a", 1, rules);
+  REQUIRE(rules.empty());
+  REQUIRE(!schema.HasBucket("/c"));
+}
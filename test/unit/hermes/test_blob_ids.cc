@@ -0,0 +1,50 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/hermes_types.h"
+#include "hermes_core/hermes_core_tasks.h"
+
+TEST_CASE("TestBlobNameKey") {
+  hermes::TagId tag1(0, 1, 1), tag2(1, 1, 1);
+  std::string name = "page_0000000000000001";
+  REQUIRE(hermes::BlobNameKey(tag1, name) == hermes::BlobNameKey(tag1, name));
+  REQUIRE(hermes::BlobNameKey(tag1, name) != hermes::BlobNameKey(tag2, name));
+  REQUIRE(hermes::BlobNameKey(tag1, name) !=
+          hermes::BlobNameKey(tag1, std::string("page_0000000000000002")));
+}
+
+TEST_CASE("TestPageBlobId") {
+  hermes::TagId tag1(0, 1, 1), tag2(0, 2, 2);
+  hermes::BlobId blob_id = hermes::GetPageBlobId(tag1, 5);
+  REQUIRE(hermes::IsPageBlobId(blob_id));
+  REQUIRE(!hermes::IsPageBlobId(hermes::BlobId(0, 1, 1)));
+  REQUIRE(hermes::GetPageIndex(blob_id) == 5);
+  REQUIRE(blob_id.hash_ ==
+          hermes::HashBlobName(tag1, hermes::GetPageBlobName(5)));
+  REQUIRE(blob_id == hermes::GetPageBlobId(tag1, 5));
+  REQUIRE(blob_id != hermes::GetPageBlobId(tag1, 6));
+  REQUIRE(blob_id != hermes::GetPageBlobId(tag2, 5));
+  // Pages past 2^32 and tags sharing the low bits do not alias
+  REQUIRE(!hermes::HasPageBlobId(tag1, (size_t(1) << 32) | 5));
+  REQUIRE(!hermes::HasPageBlobId(hermes::TagId(0, 1, (u64(1) << 32) | 1), 5));
+  REQUIRE(hermes::HasPageBlobId(tag1, 0xffffffff));
+  // Pages out of range have no ID and are addressed by name
+  REQUIRE(hermes::GetPageBlobId(tag1, (size_t(1) << 32) | 5).IsNull());
+  REQUIRE(hermes::FindPageBlobId(
+              tag1, hermes::GetPageBlobName((size_t(1) << 32) | 5))
+              .IsNull());
+  // Page names resolve to the page ID
+  REQUIRE(hermes::FindPageBlobId(tag1, hermes::GetPageBlobName(5)) ==
+          blob_id);
+  REQUIRE(hermes::FindPageBlobId(tag1, std::string("page")).IsNull());
+}
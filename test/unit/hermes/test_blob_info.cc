@@ -0,0 +1,61 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/hermes_types.h"
+
+TEST_CASE("TestBlobBuffers") {
+  hermes::BlobInfo blob_info;
+  REQUIRE(blob_info.FindBuffer(0) == 0);
+  size_t sizes[] = {100, 4096, 1, 50};
+  for (size_t size : sizes) {
+    chi::Block block;
+    block.off_ = 0;
+    block.size_ = size;
+    blob_info.AppendBuffer(hermes::TargetId(), block);
+  }
+  REQUIRE(blob_info.GetBufferCapacity() == 4247);
+  REQUIRE(blob_info.FindBuffer(0) == 0);
+  REQUIRE(blob_info.FindBuffer(99) == 0);
+  REQUIRE(blob_info.FindBuffer(100) == 1);
+  REQUIRE(blob_info.FindBuffer(4195) == 1);
+  REQUIRE(blob_info.FindBuffer(4196) == 2);
+  REQUIRE(blob_info.FindBuffer(4197) == 3);
+  REQUIRE(blob_info.FindBuffer(4246) == 3);
+  REQUIRE(blob_info.FindBuffer(4247) == 4);
+  REQUIRE(blob_info.GetBufferOff(3) == 4197);
+  REQUIRE(blob_info.GetBufferOff(4) == 4247);
+}
+
+TEST_CASE("TestBlobTruncateBuffers") {
+  hermes::BlobInfo blob_info;
+  size_t sizes[] = {100, 4096, 1, 50};
+  for (size_t size : sizes) {
+    chi::Block block;
+    block.off_ = 0;
+    block.size_ = size;
+    blob_info.AppendBuffer(hermes::TargetId(), block);
+  }
+  // Truncation keeps the buffer holding the last byte
+  std::vector<hermes::BufferInfo> freed;
+  blob_info.TruncateBuffers(5000, freed);
+  REQUIRE(freed.size() == 0);
+  blob_info.TruncateBuffers(4197, freed);
+  REQUIRE(freed.size() == 1);
+  REQUIRE(blob_info.GetBufferCapacity() == 4197);
+  blob_info.TruncateBuffers(101, freed);
+  REQUIRE(freed.size() == 2);
+  REQUIRE(blob_info.GetBufferCapacity() == 4196);
+  blob_info.TruncateBuffers(0, freed);
+  REQUIRE(freed.size() == 4);
+  REQUIRE(blob_info.GetBufferCapacity() == 0);
+}
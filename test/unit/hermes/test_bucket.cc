@@ -226,6 +226,49 @@ TEST_CASE("TestHermesPartialPutGet") {
   }
 }
 
+TEST_CASE("TestHermesBatchPutGet") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a bucket
+  hermes::Context ctx;
+  hermes::Bucket bkt("hello_batch");
+
+  size_t count_per_proc = 64;
+  size_t off = rank * count_per_proc;
+  size_t proc_count = off + count_per_proc;
+  std::vector<std::string> blob_names;
+  std::vector<hermes::Blob> blobs(count_per_proc);
+  for (size_t i = off; i < proc_count; ++i) {
+    blob_names.emplace_back(std::to_string(i));
+    hermes::Blob &blob = blobs[i - off];
+    blob.resize(KILOBYTES(64));
+    memset(blob.data(), i % 256, blob.size());
+  }
+
+  // Put all blobs in one batch
+  std::vector<hermes::BlobId> blob_ids = bkt.PutMany(blob_names, blobs, ctx);
+  REQUIRE(blob_ids.size() == count_per_proc);
+  for (hermes::BlobId &blob_id : blob_ids) {
+    REQUIRE(!blob_id.IsNull());
+  }
+
+  // Get all blobs in one batch
+  std::vector<hermes::Blob> blobs2;
+  std::vector<hermes::BlobId> blob_ids2 = bkt.GetMany(blob_names, blobs2, ctx);
+  REQUIRE(blobs2.size() == count_per_proc);
+  for (size_t i = 0; i < count_per_proc; ++i) {
+    REQUIRE(blob_ids[i] == blob_ids2[i]);
+    REQUIRE(blobs[i] == blobs2[i]);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
 TEST_CASE("TestHermesSerializedPutGet") {
   int rank, nprocs;
   MPI_Barrier(MPI_COMM_WORLD);
@@ -286,6 +329,104 @@ TEST_CASE("TestHermesBlobDestroy") {
   }
 }
 
+TEST_CASE("TestHermesBlobTruncate") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a bucket
+  hermes::Context ctx;
+  hermes::Bucket bkt("hello_truncate");
+
+  size_t count_per_proc = 16;
+  size_t off = rank * count_per_proc;
+  size_t proc_count = off + count_per_proc;
+  for (size_t i = off; i < proc_count; ++i) {
+    // Put a blob
+    hermes::Blob blob(MEGABYTES(1));
+    memset(blob.data(), i % 256, blob.size());
+    hermes::BlobId blob_id = bkt.Put(std::to_string(i), blob, ctx);
+    // Shrink it and verify the remaining data
+    bkt.TruncateBlob(blob_id, KILOBYTES(5), ctx);
+    REQUIRE(bkt.GetBlobSize(blob_id) == KILOBYTES(5));
+    hermes::Blob blob2;
+    bkt.Get(blob_id, blob2, ctx);
+    REQUIRE(blob2.size() == KILOBYTES(5));
+    REQUIRE(memcmp(blob2.data(), blob.data(), blob2.size()) == 0);
+    bkt.TruncateBlob(blob_id, 0, ctx);
+    REQUIRE(bkt.GetBlobSize(blob_id) == 0);
+  }
+}
+
+TEST_CASE("TestHermesBucketClear") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a bucket
+  hermes::Context ctx;
+  hermes::Bucket bkt("hello_clear_" + std::to_string(rank));
+
+  size_t count_per_proc = 16;
+  for (int rep = 0; rep < 2; ++rep) {
+    for (size_t i = 0; i < count_per_proc; ++i) {
+      hermes::Blob blob(KILOBYTES(4));
+      memset(blob.data(), (i + rep) % 256, blob.size());
+      hermes::BlobId blob_id = bkt.Put(std::to_string(i), blob, ctx);
+      hermes::Blob blob2;
+      bkt.Get(blob_id, blob2, ctx);
+      REQUIRE(blob == blob2);
+    }
+    // Cleared blobs are hidden immediately and reclaimed later
+    bkt.Clear();
+    for (size_t i = 0; i < count_per_proc; ++i) {
+      REQUIRE(!bkt.ContainsBlob(std::to_string(i)));
+    }
+  }
+}
+
+TEST_CASE("TestHermesBucketClearMultiNode") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Every rank puts into the same bucket, so its blobs span the nodes
+  hermes::Context ctx;
+  hermes::Bucket bkt("hello_clear_shared");
+  size_t count_per_proc = 16;
+  size_t off = rank * count_per_proc;
+  size_t proc_count = off + count_per_proc;
+  for (size_t i = off; i < proc_count; ++i) {
+    hermes::Blob blob(KILOBYTES(4));
+    memset(blob.data(), i % 256, blob.size());
+    bkt.Put(std::to_string(i), blob, ctx);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // One rank clears; every rank must stop seeing the blobs
+  if (rank == 0) {
+    bkt.Clear();
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  for (size_t i = 0; i < count_per_proc * nprocs; ++i) {
+    REQUIRE(!bkt.ContainsBlob(std::to_string(i)));
+  }
+  REQUIRE(bkt.GetSize() == 0);
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
 TEST_CASE("TestHermesBucketDestroy") {
   int rank, nprocs;
   MPI_Barrier(MPI_COMM_WORLD);
@@ -341,11 +482,14 @@ TEST_CASE("TestHermesReorganizeBlob") {
     hermes::Blob blob(KILOBYTES(4));
     memset(blob.data(), i % 256, blob.size());
     hermes::BlobId blob_id = bkt.Put(std::to_string(i), blob, ctx);
-    bkt.ReorganizeBlob(blob_id, .5, ctx);
-    hermes::Blob blob2;
-    bkt.Get(blob_id, blob2, ctx);
-    REQUIRE(blob.size() == blob2.size());
-    REQUIRE(blob == blob2);
+    // Move the blob down to the slowest tier and back up
+    for (float score : {.5f, 0.0f, 1.0f}) {
+      bkt.ReorganizeBlob(blob_id, score, ctx);
+      hermes::Blob blob2;
+      bkt.Get(blob_id, blob2, ctx);
+      REQUIRE(blob.size() == blob2.size());
+      REQUIRE(blob == blob2);
+    }
   }
 
   for (size_t i = off; i < proc_count; ++i) {
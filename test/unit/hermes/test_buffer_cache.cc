@@ -0,0 +1,57 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/buffer_cache.h"
+
+TEST_CASE("TestBufferCache") {
+  hermes::BufferCache cache({KILOBYTES(4), KILOBYTES(64)});
+  REQUIRE(cache.GetRefillSize() == KILOBYTES(256));
+  for (size_t i = 0; i < 4; ++i) {
+    chi::Block small, big;
+    small.off_ = i * KILOBYTES(4);
+    small.size_ = KILOBYTES(4);
+    big.off_ = MEGABYTES(1) + i * KILOBYTES(64);
+    big.size_ = KILOBYTES(64);
+    cache.Put(small);
+    cache.Put(big);
+  }
+  REQUIRE(cache.GetCached() == 4 * KILOBYTES(68));
+  // Small requests are served from the small slab
+  std::vector<chi::Block> blocks;
+  REQUIRE(cache.Take(KILOBYTES(4), blocks) == KILOBYTES(4));
+  REQUIRE(blocks.back().size_ == KILOBYTES(4));
+  // Large requests take big slabs first
+  blocks.clear();
+  REQUIRE(cache.Take(KILOBYTES(132), blocks) >= KILOBYTES(132));
+  REQUIRE(blocks[0].size_ == KILOBYTES(64));
+  // Running dry returns what is left
+  blocks.clear();
+  size_t left = cache.GetCached();
+  REQUIRE(cache.Take(MEGABYTES(1), blocks) == left);
+  REQUIRE(cache.GetCached() == 0);
+  // Drain keeps at most the requested amount
+  for (chi::Block &block : blocks) {
+    cache.Put(block);
+  }
+  std::vector<chi::Block> drained;
+  cache.Drain(KILOBYTES(8), drained);
+  REQUIRE(cache.GetCached() <= KILOBYTES(8));
+  REQUIRE(!drained.empty());
+  // Refills are bounded by the cache's share of the target
+  size_t share = hermes::BufferCache::GetCacheShare(MEGABYTES(50), 32);
+  hermes::BufferCache bounded({KILOBYTES(4), MEGABYTES(1)}, KILOBYTES(4),
+                              share);
+  REQUIRE(bounded.GetMaxCached() <= share);
+  REQUIRE(32 * bounded.GetMaxCached() <=
+          MEGABYTES(50) / hermes::BufferCache::kTargetShare);
+}
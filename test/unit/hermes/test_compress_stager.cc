@@ -0,0 +1,93 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cstdio>
+
+#include "basic_test.h"
+#include "hermes/data_stager/compress_stager.h"
+#include "hermes/hermes.h"
+
+/** Run one I/O of \a data at \a off of \a page through \a stager */
+static ssize_t StagePage(hermes::CompressStager &stager, size_t page,
+                         size_t off, std::vector<char> &data, bool is_read) {
+  FullPtr<char> buf = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, data.size());
+  if (!is_read) {
+    memcpy(buf.ptr_, data.data(), data.size());
+  }
+  std::vector<hermes::StageIo> ios(1);
+  hermes::StageIo &io = ios[0];
+  io.blob_name_ = hermes::adapter::BlobPlacement::CreateBlobName(page).str();
+  io.blob_off_ = off;
+  io.data_ = buf.shm_;
+  io.size_ = data.size();
+  io.is_read_ = is_read;
+  stager.Submit(HSHM_MCTX, HERMES_CONF->mdm_, hermes::TagId::GetNull(), ios);
+  stager.Reap(ios);
+  if (is_read && io.result_ > 0) {
+    memcpy(data.data(), buf.ptr_, io.result_);
+  }
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, buf.shm_);
+  return io.result_;
+}
+
+TEST_CASE("TestCompressStager") {
+  HERMES->ClientInit();
+  std::string path = "/tmp/test_compress_stager.bin";
+  std::remove(path.c_str());
+  std::remove((path + ".hidx").c_str());
+  size_t page_size = KILOBYTES(4);
+  std::string params = hermes::CompressStager::BuildFileParams(page_size);
+  std::vector<char> page0(page_size, 'a');
+  std::vector<char> part(100, 'b');
+  std::vector<char> data(page_size);
+  {
+    hermes::CompressStager stager;
+    stager.RegisterStager(HSHM_MCTX, path, params);
+    REQUIRE(StagePage(stager, 0, 0, page0, false) == (ssize_t)page_size);
+    // Partial writes merge with the stored page
+    REQUIRE(StagePage(stager, 0, 1000, part, false) == (ssize_t)part.size());
+    REQUIRE(StagePage(stager, 1, 10, part, false) == (ssize_t)part.size());
+    memcpy(page0.data() + 1000, part.data(), part.size());
+    REQUIRE(StagePage(stager, 0, 0, data, true) == (ssize_t)page_size);
+    REQUIRE(data == page0);
+    REQUIRE(StagePage(stager, 1, 0, data, true) == 110);
+    REQUIRE(memcmp(data.data() + 10, part.data(), part.size()) == 0);
+    // Truncating into page 0 cuts it short and drops page 1
+    stager.Truncate(HSHM_MCTX, HERMES_CONF->mdm_, hermes::TagId::GetNull(),
+                    2000);
+    REQUIRE(StagePage(stager, 1, 0, data, true) == 0);
+  }
+  {
+    // A new stager of the same file reloads the page index
+    hermes::CompressStager stager;
+    stager.RegisterStager(HSHM_MCTX, path, params);
+    REQUIRE(StagePage(stager, 0, 0, data, true) == 2000);
+    REQUIRE(memcmp(data.data(), page0.data(), 2000) == 0);
+    REQUIRE(StagePage(stager, 1, 0, data, true) == 0);
+  }
+  std::remove(path.c_str());
+  std::remove((path + ".hidx").c_str());
+}
+
+TEST_CASE("TestCompressStagerPageSize") {
+  HERMES->ClientInit();
+  std::string path = "/tmp/test_compress_stager_big.bin";
+  // Page sizes must fit the u32 sizes of the page index
+  hermes::CompressStager stager;
+  stager.RegisterStager(HSHM_MCTX, path,
+                        hermes::CompressStager::BuildFileParams(
+                            (size_t)1 << 32));
+  std::vector<char> data(KILOBYTES(4), 'a');
+  REQUIRE(StagePage(stager, 0, 0, data, false) < 0);
+  REQUIRE(StagePage(stager, 0, 0, data, true) < 0);
+  std::remove(path.c_str());
+}
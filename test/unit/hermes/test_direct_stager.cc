@@ -0,0 +1,80 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <sys/stat.h>
+
+#include <cstdio>
+
+#include "basic_test.h"
+#include "hermes/data_stager/direct_stager.h"
+#include "hermes/hermes.h"
+
+/** Write or read \a size bytes at \a off of page \a page of \a stager */
+static ssize_t StagePart(hermes::DirectFileStager &stager, size_t page,
+                         size_t off, char *data, size_t size, bool is_read) {
+  // One spare byte lets the I/O start at a misaligned address
+  FullPtr<char> buf = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, size + 1);
+  char *ptr = buf.ptr_ + 1;
+  if (!is_read) {
+    memcpy(ptr, data, size);
+  }
+  std::vector<hermes::StageIo> ios(1);
+  hermes::StageIo &io = ios[0];
+  io.blob_name_ = hermes::adapter::BlobPlacement::CreateBlobName(page).str();
+  io.blob_off_ = off;
+  io.data_ = buf.shm_ + 1;
+  io.size_ = size;
+  io.is_read_ = is_read;
+  stager.Submit(HSHM_MCTX, HERMES_CONF->mdm_, hermes::TagId::GetNull(), ios);
+  stager.Reap(ios);
+  if (is_read && io.result_ > 0) {
+    memcpy(data, ptr, io.result_);
+  }
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, buf.shm_);
+  return io.result_;
+}
+
+TEST_CASE("TestDirectStagerUnaligned") {
+  HERMES->ClientInit();
+  // O_DIRECT needs a real file system, which /tmp may not be
+  std::string path = std::string(getenv("HOME")) + "/test_direct_stager.bin";
+  std::remove(path.c_str());
+  size_t page_size = KILOBYTES(16);
+  hermes::DirectFileStager stager;
+  stager.RegisterStager(HSHM_MCTX, path,
+                        hermes::DirectFileStager::BuildFileParams(page_size));
+  std::vector<char> expect(3 * KILOBYTES(4), 'x');
+  REQUIRE(StagePart(stager, 0, 0, expect.data(), expect.size(), false) ==
+          (ssize_t)expect.size());
+  // A write with a partial head block and a partial tail block
+  std::vector<char> part(100, 'y');
+  REQUIRE(StagePart(stager, 0, 4000, part.data(), part.size(), false) ==
+          (ssize_t)part.size());
+  memcpy(expect.data() + 4000, part.data(), part.size());
+  // A write past the end keeps the file at its exact size
+  size_t tail_off = expect.size() + 10;
+  REQUIRE(StagePart(stager, 0, tail_off, part.data(), part.size(), false) ==
+          (ssize_t)part.size());
+  expect.resize(tail_off, 0);
+  expect.insert(expect.end(), part.begin(), part.end());
+  struct stat st;
+  REQUIRE(stat(path.c_str(), &st) == 0);
+  REQUIRE((size_t)st.st_size == expect.size());
+  // Unaligned reads see every write
+  std::vector<char> data(expect.size());
+  REQUIRE(StagePart(stager, 0, 0, data.data(), data.size(), true) ==
+          (ssize_t)data.size());
+  REQUIRE(data == expect);
+  REQUIRE(StagePart(stager, 0, 3990, data.data(), 120, true) == 120);
+  REQUIRE(memcmp(data.data(), expect.data() + 3990, 120) == 0);
+  std::remove(path.c_str());
+}
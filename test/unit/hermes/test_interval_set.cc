@@ -0,0 +1,49 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/interval_set.h"
+
+TEST_CASE("TestIntervalSet") {
+  hermes::IntervalSet valid;
+  valid.Insert(10, 10);
+  valid.Insert(30, 10);
+  valid.Insert(20, 5);
+  REQUIRE(valid.size() == 2);
+  REQUIRE(valid.Contains(10, 15));
+  REQUIRE(!valid.Contains(10, 16));
+  // A stage-in reads only the bytes no put has written
+  std::vector<hermes::Extent> gaps;
+  valid.GetGaps(0, 50, gaps);
+  REQUIRE(gaps.size() == 3);
+  REQUIRE(gaps[0] == hermes::Extent{0, 10});
+  REQUIRE(gaps[1] == hermes::Extent{25, 5});
+  REQUIRE(gaps[2] == hermes::Extent{40, 10});
+  valid.Insert(0, 50);
+  gaps.clear();
+  valid.GetGaps(0, 50, gaps);
+  REQUIRE(gaps.empty());
+  // Erasing splits ranges and truncation drops the tail
+  valid.Erase(15, 5);
+  REQUIRE(valid.size() == 2);
+  REQUIRE(!valid.Contains(15, 1));
+  valid.Truncate(30);
+  std::vector<hermes::Extent> extents;
+  valid.GetExtents(0, 100, extents);
+  REQUIRE(extents.size() == 2);
+  REQUIRE(extents[1] == hermes::Extent{20, 10});
+  // Flushing takes the dirty ranges and leaves the blob clean
+  hermes::IntervalSet dirty;
+  dirty.swap(valid);
+  REQUIRE(valid.empty());
+  REQUIRE(dirty.size() == 2);
+}
@@ -0,0 +1,122 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cstdio>
+
+#include "basic_test.h"
+#include "hermes/data_stager/io_uring_stager.h"
+#include "hermes/hermes.h"
+
+/** A page I/O of \a buf at \a buf_off */
+static hermes::StageIo MakeIo(FullPtr<char> &buf, size_t buf_off, size_t page,
+                              size_t size, bool is_read) {
+  hermes::StageIo io;
+  io.blob_name_ = hermes::adapter::BlobPlacement::CreateBlobName(page).str();
+  io.data_ = buf.shm_ + buf_off;
+  io.size_ = size;
+  io.is_read_ = is_read;
+  return io;
+}
+
+/** Submit \a ios and reap them until all are done */
+static void RunIos(hermes::IoUringStager &stager,
+                   std::vector<hermes::StageIo> &ios) {
+  stager.Submit(HSHM_MCTX, HERMES_CONF->mdm_, hermes::TagId::GetNull(), ios);
+  while (!stager.Reap(ios)) {
+  }
+}
+
+TEST_CASE("TestIoUringStagerBatch") {
+  HERMES->ClientInit();
+  std::string path = "/tmp/test_io_uring_stager.bin";
+  std::remove(path.c_str());
+  size_t page_size = KILOBYTES(4);
+  size_t num_pages = 10;
+  // A ring shallower than the batch makes Reap queue the rest
+  hermes::IoUringStager stager;
+  stager.RegisterStager(
+      HSHM_MCTX, path,
+      hermes::IoUringStager::BuildFileParams(page_size, 0, 1, 4));
+  FullPtr<char> src =
+      CHI_CLIENT->AllocateBuffer(HSHM_MCTX, num_pages * page_size);
+  FullPtr<char> dst =
+      CHI_CLIENT->AllocateBuffer(HSHM_MCTX, num_pages * page_size);
+  std::vector<hermes::StageIo> ios;
+  for (size_t i = 0; i < num_pages; ++i) {
+    memset(src.ptr_ + i * page_size, (int)i, page_size);
+    ios.emplace_back(MakeIo(src, i * page_size, i, page_size, false));
+  }
+  RunIos(stager, ios);
+  for (hermes::StageIo &io : ios) {
+    REQUIRE(io.done_);
+    REQUIRE(io.result_ == (ssize_t)page_size);
+  }
+  ios.clear();
+  for (size_t i = 0; i < num_pages; ++i) {
+    ios.emplace_back(MakeIo(dst, i * page_size, i, page_size, true));
+  }
+  RunIos(stager, ios);
+  for (hermes::StageIo &io : ios) {
+    REQUIRE(io.result_ == (ssize_t)page_size);
+  }
+  REQUIRE(memcmp(src.ptr_, dst.ptr_, num_pages * page_size) == 0);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, src.shm_);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, dst.shm_);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("TestIoUringStagerFallback") {
+  HERMES->ClientInit();
+  std::string path = "/tmp/test_io_uring_stager_ro.bin";
+  size_t page_size = KILOBYTES(4);
+  std::vector<char> data(2 * page_size, 'a');
+  FILE *file = fopen(path.c_str(), "w");
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+  FullPtr<char> buf = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, 2 * page_size);
+  memset(buf.ptr_, 'b', 2 * page_size);
+  {
+    // Writes are dropped, reads still go through the ring
+    hermes::IoUringStager stager;
+    stager.RegisterStager(HSHM_MCTX, path,
+                          hermes::IoUringStager::BuildFileParams(
+                              page_size, HERMES_STAGE_NO_WRITE));
+    std::vector<hermes::StageIo> ios;
+    ios.emplace_back(MakeIo(buf, 0, 0, page_size, false));
+    ios.emplace_back(MakeIo(buf, page_size, 1, page_size, true));
+    RunIos(stager, ios);
+    REQUIRE(ios[0].result_ == 0);
+    REQUIRE(ios[1].result_ == (ssize_t)page_size);
+    REQUIRE(buf.ptr_[page_size] == 'a');
+  }
+  {
+    // Reads return nothing, writes still go through the ring
+    hermes::IoUringStager stager;
+    stager.RegisterStager(HSHM_MCTX, path,
+                          hermes::IoUringStager::BuildFileParams(
+                              page_size, HERMES_STAGE_NO_READ));
+    memset(buf.ptr_, 'c', page_size);
+    std::vector<hermes::StageIo> ios;
+    ios.emplace_back(MakeIo(buf, 0, 0, page_size, false));
+    ios.emplace_back(MakeIo(buf, page_size, 1, page_size, true));
+    RunIos(stager, ios);
+    REQUIRE(ios[0].result_ == (ssize_t)page_size);
+    REQUIRE(ios[1].result_ == 0);
+  }
+  file = fopen(path.c_str(), "r");
+  REQUIRE(fread(data.data(), 1, data.size(), file) == data.size());
+  fclose(file);
+  REQUIRE(data[0] == 'c');
+  REQUIRE(data[page_size] == 'a');
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, buf.shm_);
+  std::remove(path.c_str());
+}
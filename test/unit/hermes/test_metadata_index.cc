@@ -0,0 +1,49 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/hermes_types.h"
+#include "hermes/metadata_index.h"
+
+TEST_CASE("TestMetadataIndex") {
+  hermes::MetadataIndex<hermes::BlobId, size_t> index(16);
+  for (size_t i = 0; i < 4096; ++i) {
+    REQUIRE(index.Emplace(hermes::BlobId(0, i, i), i));
+  }
+  REQUIRE(!index.Emplace(hermes::BlobId(0, 7, 7), 0));
+  for (size_t i = 0; i < 4096; i += 2) {
+    REQUIRE(index.Erase(hermes::BlobId(0, i, i)));
+  }
+  REQUIRE(index.size() == 2048);
+  for (size_t i = 0; i < 4096; ++i) {
+    size_t val;
+    bool found = index.Find(hermes::BlobId(0, i, i), val);
+    REQUIRE(found == (i % 2 == 1));
+    if (found) {
+      REQUIRE(val == i);
+    }
+  }
+}
+
+TEST_CASE("TestMetadataTable") {
+  hermes::MetadataTable<hermes::TagId, hermes::TagInfo> table(1);
+  bool did_create;
+  hermes::TagInfo &tag = table.Emplace(hermes::TagId(0, 1, 1), did_create);
+  REQUIRE(did_create);
+  for (size_t i = 2; i < 1024; ++i) {
+    table.Emplace(hermes::TagId(0, i, i), did_create);
+  }
+  REQUIRE(table.Find(hermes::TagId(0, 1, 1)) == &tag);
+  REQUIRE(table.Erase(hermes::TagId(0, 1, 1)));
+  REQUIRE(table.Find(hermes::TagId(0, 1, 1)) == nullptr);
+  REQUIRE(table.size() == 1022);
+}
@@ -0,0 +1,37 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hermes/read_ahead.h"
+
+TEST_CASE("TestReadAhead") {
+  hermes::ReadAhead ra(16);
+  std::vector<size_t> pages;
+  // A stream is detected after two reads with the same stride
+  ra.Observe(0, false, pages);
+  ra.Observe(2, false, pages);
+  REQUIRE(pages.empty());
+  ra.Observe(4, false, pages);
+  REQUIRE(pages == std::vector<size_t>{6, 8, 10, 12});
+  // Hits grow the window and pages are never issued twice
+  pages.clear();
+  ra.Observe(6, true, pages);
+  REQUIRE(ra.GetWindow() == 8);
+  REQUIRE(pages.front() == 14);
+  REQUIRE(pages.back() == 22);
+  // A broken stream that wasted its prefetches shrinks the window
+  pages.clear();
+  ra.Observe(100, false, pages);
+  ra.Observe(7, false, pages);
+  REQUIRE(pages.empty());
+  REQUIRE(ra.GetWindow() == 4);
+}
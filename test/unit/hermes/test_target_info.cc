@@ -0,0 +1,45 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cmath>
+
+#include "basic_test.h"
+#include "hermes/hermes_types.h"
+
+TEST_CASE("TestTargetCapacity") {
+  chi::BdevStats stats;
+  stats.max_cap_ = MEGABYTES(100);
+  stats.free_ = MEGABYTES(25);
+  hermes::TargetInfo target;
+  target.stats_ = &stats;
+  target.borg_max_thresh_ = .8;
+  REQUIRE(std::fabs(target.GetUsage() - .75) < 1e-6);
+  REQUIRE(target.HasRoom(MEGABYTES(5)));
+  REQUIRE(!target.HasRoom(MEGABYTES(6)));
+  target.borg_max_thresh_ = 1;
+  REQUIRE(target.HasRoom(MEGABYTES(25)));
+  REQUIRE(!target.HasRoom(MEGABYTES(26)));
+}
+
+TEST_CASE("TestTargetCached") {
+  chi::BdevStats stats;
+  stats.max_cap_ = MEGABYTES(100);
+  stats.free_ = MEGABYTES(25);
+  hermes::TargetInfo target;
+  target.stats_ = &stats;
+  // Blocks idle in lane caches are not in use
+  target.UpdateCached(MEGABYTES(15));
+  REQUIRE(std::fabs(target.GetUsage() - .6) < 1e-6);
+  target.UpdateCached(-(ssize_t)MEGABYTES(15));
+  REQUIRE(target.GetCached() == 0);
+  REQUIRE(std::fabs(target.GetUsage() - .75) < 1e-6);
+}
@@ -0,0 +1,52 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include <cstdlib>
+#include <iostream>
+
+#include "hermes/apriori_schema.h"
+
+/**
+ * Derive an apriori prefetch schema from I/O traces recorded by the
+ * Hermes runtime (prefetch.trace_path).
+ *
+ * Usage: hermes_apriori_schema <schema.yaml> <lookahead> <score> <trace>...
+ * */
+int main(int argc, char **argv) {
+  if (argc < 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " <schema.yaml> <lookahead> <score> <trace>..." << std::endl;
+    return 1;
+  }
+  std::string schema_path = argv[1];
+  size_t lookahead = std::strtoul(argv[2], nullptr, 10);
+  float score = std::strtof(argv[3], nullptr);
+  std::vector<hermes::TraceRead> trace;
+  for (int i = 4; i < argc; ++i) {
+    if (!hermes::AprioriSchema::LoadTrace(argv[i], trace)) {
+      std::cerr << "Failed to read trace " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+  hermes::AprioriSchema schema =
+      hermes::AprioriSchema::Derive(trace, lookahead, score);
+  std::ofstream out(schema_path);
+  if (!out) {
+    std::cerr << "Failed to open " << schema_path << std::endl;
+    return 1;
+  }
+  schema.Save(out);
+  std::cout << "Derived " << schema.size() << " rules from " << trace.size()
+            << " reads" << std::endl;
+  return 0;
+}